@@ -0,0 +1,681 @@
+/***************************************************************************
+  This file is part of Project Apollo - NASSP
+  Copyright (c) 2022 Niklas Beug
+
+  RTCC TLI presettings converter
+
+  Project Apollo is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Project Apollo is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Project Apollo; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  See http://nassp.sourceforge.net/license/ for more details.
+
+  **************************************************************************/
+
+#include "RTCC_TLI_Presettings.h"
+#include "RTCC_TLI_BinaryDeck.h"
+
+#include <iostream>
+#include <fstream>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+
+//Writes synthetic scenarios and a manifest for them
+int GenerateBenchmark(int argc, char *argv[]);
+//Times the stages of deck generation on the decks of a manifest
+int RunBenchmark(int argc, char *argv[]);
+void PrintUsage();
+
+//Heap allocations of the whole program, counted by the operator new below
+static std::atomic<uint64_t> HeapAllocs(0);
+
+#if defined(__GNUC__) && !defined(__clang__)
+//GCC takes the free of a replaced operator delete for a mismatch
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(size_t size)
+{
+	HeapAllocs.fetch_add(1, std::memory_order_relaxed);
+	if (void *p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+	HeapAllocs.fetch_add(1, std::memory_order_relaxed);
+	return std::malloc(size ? size : 1);
+}
+
+void operator delete(void *p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept
+{
+	std::free(p);
+}
+
+
+
+int main(int argc, char *argv[])
+{
+	if (argc > 1 && std::string(argv[1]) == "--generate") return GenerateBenchmark(argc, argv);
+	if (argc > 1 && std::string(argv[1]) == "--benchmark") return RunBenchmark(argc, argv);
+
+	PrintUsage();
+	return 2;
+}
+
+
+//Like ParseInt, the whole string has to be a finite number
+static bool ParseDouble(const std::string &str, double &val)
+{
+	char *end;
+	val = strtod(str.c_str(), &end);
+	return str.empty() == false && *end == 0 && std::isfinite(val);
+}
+
+//Index of a key of the launch window table (TP, COS and the targets C3, EN, RAS, DEC of each opportunity), else -1
+static int TableIndex(std::string_view Key, std::string_view &Name)
+{
+	static const char *const Table[] = { "LVDC_TP", "LVDC_COS", "LVDC_C3", "LVDC_EN", "LVDC_RAS", "LVDC_DEC" };
+
+	for (const char *t : Table)
+	{
+		std::string_view rest = Key;
+		size_t len = strlen(t);
+		int num = -1;
+
+		if (rest.substr(0, len) != t || rest.size() < len + 2 || (rest[len] != 'A' && rest[len] != 'B')) continue;
+		rest.remove_prefix(len + 1);
+		std::from_chars_result res = std::from_chars(rest.data(), rest.data() + rest.size(), num);
+		if (res.ec != std::errc() || res.ptr != rest.data() + rest.size()) continue;
+		Name = t;
+		return num;
+	}
+	return -1;
+}
+
+//Synthetic value of a presetting that passes the rules of ValidatePresettings, u is uniform in [0, 1)
+static double SyntheticValue(const FieldDesc &Field, double u)
+{
+	std::string_view Name;
+	int i = TableIndex(Field.Key.View(), Name);
+
+	//Index 0 of the table has -1 placeholders
+	if (i == 0) return Field.Default;
+	//Times of the table increase, 20 minutes apart
+	if (Name == "LVDC_TP") return (i - 1) * 1200.0 + 600.0 * u;
+	//Cosine of a target angle of 4 to 6 degrees
+	if (Name == "LVDC_COS") return cos((4.0 + 2.0 * u) * 3.14159265358979323846 / 180.0);
+	//The rest keeps the sign of its default and stays within 1% of it, which keeps the targets bound orbits and the
+	//launch window segments in order
+	return Field.Default != 0.0 ? Field.Default * (0.99 + 0.02 * u) : u - 0.5;
+}
+
+int GenerateBenchmark(int argc, char *argv[])
+{
+	//Filler lines of a vessel block, like the subsystem state in NASSP scenarios
+	static const char *const Filler[] =
+	{
+		"  CSWITCH_%d 1 0 1 1 0 0 1 0 1 1 0 1 0 0 1 1",
+		"  SYSTEMSSTATE %d 0.%08d 271.%05d 0",
+		"  ECSTANKS %d 1210.%04d 25.%06d 873.%03d",
+		"  CMPANEL_%d %d",
+		"  IU_STATE %d LVDCSTATE 0.%09d",
+		"  VECTOR_%d -0.%012d 0.%012d 0.%012d",
+	};
+
+	std::string Dir, line;
+	double SizeMB = 2.0, Missing = 10.0, val;
+	int Days = 20, num;
+	unsigned Seed = 1;
+	char Buffer[256];
+
+	if (argc < 3)
+	{
+		PrintUsage();
+		return 2;
+	}
+	Dir = argv[2];
+	for (int i = 3; i < argc; i++)
+	{
+		std::string arg = argv[i];
+
+		bool valid = i + 1 < argc;
+
+		if (valid == false);
+		else if ((arg == "-s" || arg == "--size") && ParseDouble(argv[++i], val) && val > 0.0) SizeMB = val;
+		else if (arg == "--missing" && ParseDouble(argv[++i], val) && val >= 0.0 && val <= 100.0) Missing = val;
+		else if ((arg == "-d" || arg == "--days") && ParseInt(argv[++i], num) && num > 0) Days = num;
+		else if (arg == "--seed" && ParseInt(argv[++i], num)) Seed = (unsigned)num;
+		else valid = false;
+
+		if (valid == false)
+		{
+			PrintUsage();
+			return 2;
+		}
+	}
+
+	//The directory and its parents are made if they don't exist
+	std::error_code ec;
+	std::filesystem::create_directories(Dir, ec);
+	if (ec)
+	{
+		std::cout << "Directory " << Dir << " can't be created: " << ec.message() << "!" << std::endl;
+		return 1;
+	}
+
+	std::vector<const FieldDesc *> Keys;
+	LayoutKeys(Keys);
+
+	//Section of each key, the section 1 keys come first
+	std::vector<int> Section(Keys.size(), 0);
+	for (size_t k = 0; k < Keys.size(); k++)
+	{
+		for (int s = 1; s < 3; s++)
+		{
+			for (size_t c = 0; c < SectionSize[s]; c++)
+			{
+				if (Keys[k] >= SectionLayout[s][c].Field && Keys[k] < SectionLayout[s][c].Field + 4) Section[k] = s;
+			}
+		}
+	}
+
+	std::mt19937_64 rng(Seed);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	std::string manifest = "#Synthetic decks for RTCC_TLI_Presettings_Benchmark --benchmark\n";
+	std::string out, lvdc;
+	std::vector<std::string> Lines(Keys.size());
+	std::string_view Name;
+
+	for (int d = 0; d < Days; d++)
+	{
+		std::string FileName = Dir + "/Scenario_" + std::to_string(d + 1) + ".scn";
+		int LaunchDay = 100 + d % MaxDeckDays;
+
+		//LVDC block, some keys are left out to exercise the defaults. The times of the launch window table are always
+		//there, a default among them would break their order. The section 2 and 3 presettings belong to the mission,
+		//so they are drawn once per deck and all its launch days share these cards.
+		lvdc.clear();
+		for (size_t k = 0; k < Keys.size(); k++)
+		{
+			if (Section[k] == 0 || d % MaxDeckDays == 0)
+			{
+				bool table = TableIndex(Keys[k]->Key.View(), Name) >= 0 && Name == "LVDC_TP";
+
+				Lines[k].clear();
+				if (table == false && uniform(rng) * 100.0 < Missing) continue;
+				snprintf(Buffer, sizeof(Buffer), "  %s %.12g\n", std::string(Keys[k]->Key.View()).c_str(), SyntheticValue(*Keys[k], uniform(rng)));
+				Lines[k] = Buffer;
+			}
+			lvdc += Lines[k];
+		}
+
+		out = "BEGIN_DESC\nSynthetic scenario for the TLI presettings benchmark\nEND_DESC\n\nBEGIN_ENVIRONMENT\n  System Sol\n  Date MJD 40418.5607\nEND_ENVIRONMENT\n\n";
+		out += "BEGIN_SHIPS\nAS-506:ProjectApollo\\Saturn5\n  STATUS Landed Earth\n  POS -80.6041140 28.6083860\n  HEADING 90.00\n";
+
+		//The LVDC block moves from the start to the end of the vessel over the launch days
+		size_t Size = (size_t)(SizeMB * 1048576.0);
+		size_t Depth = Days > 1 ? (size_t)((double)Size * d / (Days - 1)) : Size / 2;
+		bool placed = false;
+		unsigned n = 0;
+
+		out.reserve(Size + lvdc.size() + 256);
+		while (out.size() < Size)
+		{
+			if (placed == false && out.size() >= Depth)
+			{
+				out += lvdc;
+				placed = true;
+			}
+			unsigned r = (unsigned)rng();
+			snprintf(Buffer, sizeof(Buffer), Filler[n % 6], n, r % 100000000, r % 99991, r % 1000);
+			out += Buffer;
+			out += '\n';
+			n++;
+		}
+		if (placed == false) out += lvdc;
+		out += "END\nEND_SHIPS\n";
+
+		if (WriteFileAtomic(FileName, out) == false)
+		{
+			std::cout << "File " << FileName << " can't be written!" << std::endl;
+			return 1;
+		}
+
+		if (d % MaxDeckDays == 0)
+		{
+			manifest += "\nDECK " + Dir + "/Benchmark_" + std::to_string(d / MaxDeckDays + 1) + ".txt\nYEAR 1969\n";
+		}
+		manifest += "SCENARIO " + std::to_string(LaunchDay) + " " + FileName + "\n";
+	}
+
+	line = Dir + "/Benchmark.manifest";
+	if (WriteFileAtomic(line, manifest) == false)
+	{
+		std::cout << "File " << line << " can't be written!" << std::endl;
+		return 1;
+	}
+	std::cout << "File " << line << " generated!" << std::endl;
+	return 0;
+}
+
+//Key lookup of the original converter, a pass over the file for each key
+static bool LegacySearchForDouble(std::ifstream &file, const char *str, double &val, double defval)
+{
+	char buffer[256];
+	double e;
+	std::string line;
+	file.clear();
+	file.seekg(0);
+
+	while (std::getline(file, line))
+	{
+		if (sscanf(line.c_str(), "%255s", buffer) == 1 && !strcmp(buffer, str))
+		{
+			if (sscanf(line.c_str(), "%255s %lf", buffer, &e) == 2)
+			{
+				val = e;
+				return true;
+			}
+		}
+	}
+	val = defval;
+	return false;
+}
+
+//Card field formatting of the original converter
+static std::string LegacyFixedWidthString(std::string str, unsigned len)
+{
+	if (str.length() > len) return str;
+
+	std::string str2;
+	for (unsigned i = 0; i < len - str.length(); i++)
+	{
+		str2.append(" ");
+	}
+	str2.append(str);
+	return str2;
+}
+
+//Calls func at least MinRuns times and for at least half a second, returns the best time of one call in seconds
+template<class F>
+static double BestTime(F func, int MinRuns = 3)
+{
+	double best = 1e30, total = 0.0;
+
+	for (int n = 0; n < MinRuns || total < 0.5; n++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		func();
+		double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (t < best) best = t;
+		total += t;
+	}
+	return best;
+}
+
+static void PrintRate(const char *Stage, double Count, double Time, const char *Unit, double Count2 = 0.0, const char *Unit2 = nullptr)
+{
+	if (Unit2) printf("%-28s %14.0f %-10s %14.0f %s\n", Stage, Count / Time, Unit, Count2 / Time, Unit2);
+	else printf("%-28s %14.0f %s\n", Stage, Count / Time, Unit);
+}
+
+int RunBenchmark(int argc, char *argv[])
+{
+	std::vector<DeckJob> Jobs;
+	std::vector<DeckTask> Tasks;
+	unsigned Threads = 0;
+	int num;
+
+	bool valid = argc >= 3;
+
+	for (int i = 3; i < argc && valid; i++)
+	{
+		std::string arg = argv[i];
+
+		if ((arg == "-j" || arg == "--threads") && i + 1 < argc && ParseInt(argv[++i], num) && num >= 0) Threads = (unsigned)num;
+		else valid = false;
+	}
+	if (valid == false)
+	{
+		PrintUsage();
+		return 2;
+	}
+	if (ReadManifest(argv[2], Jobs) == false) return 2;
+
+	for (size_t j = 0; j < Jobs.size(); j++)
+	{
+		for (size_t i = 0; i < Jobs[j].FileNameInArr.size(); i++)
+		{
+			Tasks.push_back({ Jobs[j].FileNameInArr[i], Jobs[j].LaunchDayArr[i] });
+		}
+	}
+
+	ThreadPool pool(Threads);
+	std::vector<ScenarioIndex> Index(Tasks.size());
+	std::vector<const FieldDesc *> Keys;
+	double Bytes = 0.0, t;
+	//Results go here, so that no stage is optimized away
+	volatile double Sink = 0.0;
+
+	LayoutKeys(Keys);
+	for (size_t i = 0; i < Tasks.size(); i++)
+	{
+		MappedFile Map;
+		if (Map.Open(Tasks[i].FileName) == false)
+		{
+			std::cout << "File " << Tasks[i].FileName << " not found!" << std::endl;
+			return 1;
+		}
+		Bytes += (double)Map.Data().size();
+	}
+
+	printf("%zu scenarios, %.1f MB, %zu decks, %u threads, %s scanner\n\n", Tasks.size(), Bytes / 1048576.0, Jobs.size(), Threads ? Threads : std::thread::hardware_concurrency(), GetLineScanner().Name);
+
+	//Mapping and indexing of the scenarios
+	t = BestTime([&]
+	{
+		pool.Run(Tasks.size(), [&](size_t i) { Index[i].Load(Tasks[i].FileName); });
+	});
+	PrintRate("Scenario load", (double)Tasks.size(), t, "files/s", Bytes / 1048576.0, "MB/s");
+
+	//The same, with the files read ahead by the reader of the decks. The buffers are reused, so nothing is kept.
+	std::vector<std::string> Files(Tasks.size());
+	std::vector<uint64_t> Hashes(Tasks.size());
+	for (size_t i = 0; i < Tasks.size(); i++) Files[i] = Tasks[i].FileName;
+	t = BestTime([&]
+	{
+		ScenarioReader::Read(Files, pool, [&](size_t i, const std::string *Data)
+		{
+			ScenarioArena &arena = pool.Arena();
+			ArenaScope scope(arena);
+			ScenarioIndex in(arena.Resource());
+
+			if (Data) in.LoadRead(*Data);
+			else in.Load(Files[i]);
+			Hashes[i] = in.ContentHash();
+		});
+	});
+	PrintRate((std::string("Scenario read (") + ScenarioReader::Backend() + ")").c_str(), (double)Tasks.size(), t, "files/s", Bytes / 1048576.0, "MB/s");
+
+	//Lookups of all layout keys in all scenarios, one thread
+	t = BestTime([&]
+	{
+		double sum = 0.0, val;
+		for (size_t i = 0; i < Index.size(); i++)
+		{
+			for (size_t k = 0; k < Keys.size(); k++)
+			{
+				SearchForDouble(Index[i], Keys[k]->Key.View(), val, Keys[k]->Default);
+				sum += val;
+			}
+		}
+		Sink = Sink + sum;
+	});
+	PrintRate("SearchForDouble", (double)(Index.size() * Keys.size()), t, "lookups/s");
+
+	//The same lookups as the original converter did them, in the first scenario only
+	{
+		std::ifstream file(Tasks[0].FileName);
+		std::vector<std::string> KeyStr;
+		for (size_t k = 0; k < Keys.size(); k++) KeyStr.push_back(std::string(Keys[k]->Key.View()));
+
+		t = BestTime([&]
+		{
+			double sum = 0.0, val;
+			for (size_t k = 0; k < KeyStr.size(); k++)
+			{
+				LegacySearchForDouble(file, KeyStr[k].c_str(), val, Keys[k]->Default);
+				sum += val;
+			}
+			Sink = Sink + sum;
+		}, 1);
+		PrintRate("SearchForDouble (legacy)", (double)Keys.size(), t, "lookups/s");
+	}
+
+	//Unit conversion and validation of all scenarios as one batch
+	{
+		PresettingStore store;
+		std::vector<ScenarioError> errors;
+
+		store.Reset(Index.size());
+		for (size_t i = 0; i < Index.size(); i++) store.Extract(i, Index[i], errors);
+
+		t = BestTime([&]
+		{
+			store.Convert();
+			Sink = Sink + store.Converted(0, 0);
+		});
+		PrintRate("Unit conversion", (double)(Index.size() * SchemaSize), t, "values/s");
+
+		std::vector<PresettingViolation> Violations;
+		t = BestTime([&]
+		{
+			Violations.clear();
+			ValidatePresettings(store, Violations);
+			Sink = Sink + (double)Violations.size();
+		});
+		PrintRate("Validation", (double)Index.size(), t, "scenarios/s");
+
+		//The timings are still of interest, but not of presettings a mission would have
+		if (Violations.empty() == false)
+		{
+			size_t Failed = 1;
+			for (size_t v = 1; v < Violations.size(); v++) Failed += Violations[v].Day != Violations[v - 1].Day;
+			std::cout << Failed << " of " << Index.size() << " scenarios fail validation with " << Violations.size() << " rule violations, the first "
+				<< Tasks[Violations[0].Day].FileName << ": " << DescribeViolation(Violations[0]) << "!" << std::endl;
+		}
+	}
+
+	//Key names with opportunity and index, at run time
+	{
+		volatile char Opp = 'A';
+		volatile int Num = 0;
+		const int Count = 1000000;
+
+		t = BestTime([&]
+		{
+			size_t sum = 0;
+			for (int i = 0; i < Count; i++)
+			{
+				LVDCKey key = MakeKey("LVDC_TP", Opp, (Num + i) % 14);
+				sum += key.Len + (unsigned char)key.Str[key.Len - 1];
+			}
+			Sink = Sink + (double)sum;
+		});
+		PrintRate("Key construction", Count, t, "keys/s");
+
+		t = BestTime([&]
+		{
+			char Buff[128];
+			size_t sum = 0;
+			for (int i = 0; i < Count; i++)
+			{
+				snprintf(Buff, 128, "%s%c%d", "LVDC_TP", Opp, (Num + i) % 14);
+				std::string key(Buff);
+				sum += key.length();
+			}
+			Sink = Sink + (double)sum;
+		});
+		PrintRate("Key construction (legacy)", Count, t, "keys/s");
+	}
+
+	//Four value fields and the ID of a card
+	{
+		std::vector<double> Values(4096);
+		std::mt19937_64 rng(1);
+		std::uniform_real_distribution<double> uniform(-1e6, 1e6);
+		const int Cards = 250000;
+		CardRecord card;
+
+		for (size_t i = 0; i < Values.size(); i++) Values[i] = uniform(rng);
+
+		t = BestTime([&]
+		{
+			size_t sum = 0;
+			for (int i = 0; i < Cards; i++)
+			{
+				for (int f = 0; f < 4; f++) FormatValue(card.Text + 17 * f, Values[(4 * i + f) & 4095]);
+				FormatID(card.Text + 68, "69197", 1 + (i & 1), i % 620 + 1);
+				sum += (unsigned char)card.Text[16] + (unsigned char)card.Text[79];
+			}
+			Sink = Sink + (double)sum;
+		});
+		PrintRate("FormatValue/FormatID", Cards, t, "cards/s", Cards * 5.0, "fields/s");
+
+		t = BestTime([&]
+		{
+			char Buffer[128];
+			size_t sum = 0;
+			for (int i = 0; i < Cards; i++)
+			{
+				std::string line;
+				for (int f = 0; f < 4; f++)
+				{
+					snprintf(Buffer, 127, "%.8E", Values[(4 * i + f) & 4095]);
+					line += LegacyFixedWidthString(Buffer, 17U);
+				}
+				snprintf(Buffer, 7, "%01d%03d", 1 + (i & 1), i % 620 + 1);
+				line += LegacyFixedWidthString(std::string("69197") + Buffer, 12U);
+				sum += line.length();
+			}
+			Sink = Sink + (double)sum;
+		});
+		PrintRate("Formatting (legacy)", Cards, t, "cards/s", Cards * 5.0, "fields/s");
+	}
+
+	//Whole decks, rendered in memory. Nothing is cached or written.
+	{
+		std::vector<ScenarioCards> Cards(Tasks.size());
+		std::vector<std::string> Out(Jobs.size());
+		std::string Error;
+		std::error_code ec;
+		CardCache NoCache;
+		size_t CardCount = 0;
+
+		auto Generate = [&]
+		{
+			CardInterner intern;
+			pool.Run(Tasks.size(), [&](size_t i) { ReadScenario(Tasks[i].FileName, Tasks[i].LaunchDay, Cards[i], NoCache, &intern, nullptr, &pool.Arena()); });
+			size_t first = 0;
+			CardCount = 0;
+			for (size_t j = 0; j < Jobs.size(); j++)
+			{
+				Out[j].clear();
+				WriteDeck(Jobs[j], &Cards[first], Out[j], Error);
+				first += Jobs[j].FileNameInArr.size();
+			}
+			for (size_t i = 0; i < Cards.size(); i++)
+			{
+				CardCount += Cards[i].Section[0].size() + Cards[i].Section[1].size() + Cards[i].Section[2].size();
+			}
+		};
+		t = BestTime(Generate);
+		PrintRate("Deck generation", (double)Tasks.size(), t, "files/s", (double)CardCount, "cards/s");
+
+		//One more run, the arenas have grown to the scenarios by now and must not go to the heap any more.
+		//What is left are the cards of the interner, which is new for each run.
+		uint64_t Heap = HeapAllocs, Arena = pool.ArenaHeapAllocs();
+		Generate();
+		Heap = HeapAllocs - Heap;
+		Arena = pool.ArenaHeapAllocs() - Arena;
+		printf("%-28s %14.1f per scenario, %llu from the arenas\n", "Heap allocations", (double)Heap / Tasks.size(), (unsigned long long)Arena);
+		if (Arena > 0)
+		{
+			std::cout << "The scenario arenas still allocate from the heap!" << std::endl;
+			return 1;
+		}
+
+		//The binary deck of the first deck, mapped from a temporary file and looked up card by card
+		std::string Bin, TempFile = (std::filesystem::temp_directory_path() / "RTCC_TLI_Benchmark.bin").string();
+		if (WriteBinaryDeck(Jobs[0], &Cards[0], Bin, Error) == false || WriteFileAtomic(TempFile, Bin) == false)
+		{
+			std::cout << "Binary deck " << TempFile << " can't be written!" << std::endl;
+			return 1;
+		}
+		TLIBinaryDeck deck;
+		if (deck.Open(TempFile.c_str()) == false)
+		{
+			std::cout << "Binary deck " << TempFile << " can't be opened!" << std::endl;
+			return 1;
+		}
+		t = BestTime([&]
+		{
+			size_t found = 0;
+			for (size_t i = 0; i < deck.CardCount(); i++)
+			{
+				const TLIBinaryCard &c = deck.Cards()[i];
+				found += deck.Find(c.LaunchDay, c.Opp, c.Card) == &c;
+			}
+			Sink = Sink + (double)found;
+		});
+		PrintRate("Binary deck lookup", (double)deck.CardCount(), t, "cards/s");
+		deck.Close();
+
+		//Headers that don't fit the layout must not open, even where the card count would overflow
+		TLIBinaryHeader h;
+		memcpy(&h, Bin.data(), sizeof(h));
+		TLIBinaryHeader Bad[3] = { h, h, h };
+		Bad[0].Days = 1U << 31;
+		Bad[0].SectionCards[0] = Bad[0].SectionCards[1] = 0xFFFFFFFF;
+		Bad[0].SectionCards[2] = 2;
+		Bad[0].Cards = 0;
+		Bad[1].Days = 0;
+		Bad[1].Cards = 0;
+		Bad[2].Days = TLIBinaryMaxDays + 1;
+		Bad[2].Cards = 0;
+		for (const TLIBinaryHeader &b : Bad)
+		{
+			if (WriteFileAtomic(TempFile, std::string((const char *)&b, sizeof(b))) && deck.Open(TempFile.c_str()))
+			{
+				std::cout << "A binary deck with a damaged header was opened!" << std::endl;
+				return 1;
+			}
+		}
+		std::filesystem::remove(TempFile, ec);
+	}
+	return 0;
+}
+
+
+void PrintUsage()
+{
+	std::cout << "Usage:" << std::endl;
+	std::cout << "  RTCC_TLI_Presettings_Benchmark --generate <dir> [-s <MB>] [-d <days>] [--missing <percent>] [--seed <n>]" << std::endl;
+	std::cout << "      Synthetic scenarios of <MB> each for <days> launch days, and <dir>/Benchmark.manifest" << std::endl;
+	std::cout << "      <MB> is greater than 0, <percent> of the presettings (0 to 100) are left out" << std::endl;
+	std::cout << "  RTCC_TLI_Presettings_Benchmark --benchmark <manifest> [-j <threads>]" << std::endl;
+	std::cout << "      Times the stages of deck generation, no deck is written" << std::endl;
+}
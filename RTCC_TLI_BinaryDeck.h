@@ -0,0 +1,256 @@
+/***************************************************************************
+  This file is part of Project Apollo - NASSP
+  Copyright (c) 2022 Niklas Beug
+
+  RTCC TLI presettings converter
+
+  Project Apollo is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Project Apollo is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Project Apollo; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  See http://nassp.sourceforge.net/license/ for more details.
+
+  **************************************************************************/
+
+//Binary TLI deck, the cards of a text deck as fixed size records. The file is mapped and used in place, nothing is
+//parsed. This header has no dependencies on the converter and can be copied into the projects that read decks.
+//
+//Layout: a 64 byte header, then one record per card in the order of the text deck, by section, then by launch day.
+//Numbers are little endian.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+constexpr char TLIBinaryMagic[8] = { 'T', 'L', 'I', 'D', 'E', 'C', 'K', 'B' };
+constexpr uint32_t TLIBinaryVersion = 1;
+//Layout of the decks of this version: 1 to 10 launch days, and for each section the number of its first card and its
+//cards per launch day
+constexpr uint32_t TLIBinaryMaxDays = 10;
+constexpr uint32_t TLIBinaryFirstCard[3] = { 1, 461, 541 };
+constexpr uint32_t TLIBinarySectionCards[3] = { 46, 8, 8 };
+
+struct TLIBinaryHeader
+{
+	char Magic[8];
+	uint32_t Version;
+	//Sizes of this header and of a card record
+	uint32_t HeaderSize;
+	uint32_t RecordSize;
+	//Year of launch, e.g. 1969
+	uint32_t Year;
+	//Launch days, and cards of all launch days
+	uint32_t Days;
+	uint32_t Cards;
+	//Number of the first card of each section, and cards per launch day in each section
+	uint32_t FirstCard[3];
+	uint32_t SectionCards[3];
+	uint32_t Reserved[2];
+};
+
+//One card
+struct TLIBinaryCard
+{
+	//Card ID: two digit year, day of year, opportunity and card number
+	uint16_t Year;
+	uint16_t LaunchDay;
+	uint16_t Opp;
+	uint16_t Card;
+	//Fields in RTCC units, the values of the text card with its 9 digits
+	double Field[4];
+};
+
+static_assert(sizeof(TLIBinaryHeader) == 64, "Header layout");
+static_assert(sizeof(TLIBinaryCard) == 40, "Record layout");
+
+//Read only view of a mapped binary deck. The lookups compute the position of a record, only a launch day is searched
+//among the few of the deck.
+class TLIBinaryDeck
+{
+public:
+	TLIBinaryDeck() : Ptr(nullptr), Size(0) {}
+	~TLIBinaryDeck() { Close(); }
+	TLIBinaryDeck(const TLIBinaryDeck &) = delete;
+	TLIBinaryDeck &operator=(const TLIBinaryDeck &) = delete;
+
+	//Maps the file, returns false if it can't be opened or isn't a binary deck of this version
+	bool Open(const char *FileName)
+	{
+		Close();
+#ifdef _WIN32
+		HANDLE hFile = CreateFileA(FileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (hFile == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER size;
+		HANDLE hMapping = NULL;
+		if (GetFileSizeEx(hFile, &size) && size.QuadPart >= (LONGLONG)sizeof(TLIBinaryHeader))
+		{
+			hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		}
+		CloseHandle(hFile);
+		if (hMapping == NULL) return false;
+
+		Ptr = (const char *)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(hMapping);
+		if (Ptr == nullptr) return false;
+		Size = (size_t)size.QuadPart;
+#else
+		int fd = open(FileName, O_RDONLY);
+		if (fd < 0) return false;
+
+		struct stat st;
+		void *p = MAP_FAILED;
+		if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(TLIBinaryHeader))
+		{
+			p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		}
+		close(fd);
+		if (p == MAP_FAILED) return false;
+
+		Ptr = (const char *)p;
+		Size = (size_t)st.st_size;
+#endif
+		if (Valid() == false)
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void Close()
+	{
+		if (Ptr == nullptr) return;
+#ifdef _WIN32
+		UnmapViewOfFile(Ptr);
+#else
+		munmap((void *)Ptr, Size);
+#endif
+		Ptr = nullptr;
+		Size = 0;
+	}
+
+	const TLIBinaryHeader &Header() const { return *(const TLIBinaryHeader *)Ptr; }
+	int Year() const { return (int)Header().Year; }
+	size_t Days() const { return Header().Days; }
+	//All cards in deck order
+	size_t CardCount() const { return Header().Cards; }
+	const TLIBinaryCard *Cards() const { return (const TLIBinaryCard *)(Ptr + sizeof(TLIBinaryHeader)); }
+
+	//Cards of section s per launch day, 0 if there is no section s
+	size_t SectionCards(int s) const { return s >= 0 && s < 3 ? Header().SectionCards[s] : 0; }
+	//Cards of section s of the launch day at position Day of the deck, SectionCards(s) of them.
+	//nullptr if there is no such launch day or section.
+	const TLIBinaryCard *Section(size_t Day, int s) const
+	{
+		const TLIBinaryHeader &h = Header();
+		size_t first = 0;
+
+		if (Day >= h.Days || s < 0 || s >= 3) return nullptr;
+		for (int i = 0; i < s; i++) first += (size_t)h.Days * h.SectionCards[i];
+		return Cards() + first + Day * h.SectionCards[s];
+	}
+	//Launch day at position Day of the deck, -1 if there is none
+	int LaunchDay(size_t Day) const
+	{
+		//The first section with cards has the launch day of each position
+		for (int s = 0; s < 3; s++)
+		{
+			if (SectionCards(s) > 0) return Day < Days() ? Section(Day, s)->LaunchDay : -1;
+		}
+		return -1;
+	}
+	//Position of a launch day in the deck, -1 if the deck doesn't have it. A deck has only a few launch days.
+	long DayIndex(int DayOfYear) const
+	{
+		for (size_t d = 0; d < Days(); d++)
+		{
+			if (LaunchDay(d) == DayOfYear) return (long)d;
+		}
+		return -1;
+	}
+
+	//Card by its number, nullptr if the deck doesn't have it
+	const TLIBinaryCard *Card(int Number) const
+	{
+		const TLIBinaryHeader &h = Header();
+		size_t first = 0;
+
+		for (int s = 0; s < 3; s++)
+		{
+			size_t n = (size_t)h.Days * h.SectionCards[s];
+			if (Number >= (int)h.FirstCard[s] && (size_t)(Number - (int)h.FirstCard[s]) < n) return Cards() + first + (Number - (int)h.FirstCard[s]);
+			first += n;
+		}
+		return nullptr;
+	}
+	//Card by its ID, nullptr if the deck has no card with this launch day, opportunity and number. The record is
+	//found from the position of the launch day, the section of the number and the card within the section.
+	const TLIBinaryCard *Find(int LaunchDay, int Opp, int Number) const
+	{
+		const TLIBinaryHeader &h = Header();
+		long Day = DayIndex(LaunchDay);
+
+		if (Day < 0) return nullptr;
+		for (int s = 0; s < 3; s++)
+		{
+			//Numbers of the section for this launch day
+			long first = (long)h.FirstCard[s] + Day * (long)h.SectionCards[s];
+			if (Number < first || Number - first >= (long)h.SectionCards[s]) continue;
+
+			const TLIBinaryCard *card = Section((size_t)Day, s) + (Number - first);
+			return card->Opp == Opp ? card : nullptr;
+		}
+		return nullptr;
+	}
+
+protected:
+	//Header checks, the records are then in bounds. The layout is checked against the fixed one of this version,
+	//so the card count can't overflow and every lookup stays within the file.
+	bool Valid() const
+	{
+		const TLIBinaryHeader &h = Header();
+		uint64_t PerDay = 0;
+
+		if (memcmp(h.Magic, TLIBinaryMagic, sizeof(h.Magic)) != 0 || h.Version != TLIBinaryVersion) return false;
+		if (h.HeaderSize != sizeof(TLIBinaryHeader) || h.RecordSize != sizeof(TLIBinaryCard)) return false;
+		if (h.Days == 0 || h.Days > TLIBinaryMaxDays) return false;
+		for (int s = 0; s < 3; s++)
+		{
+			if (h.FirstCard[s] != TLIBinaryFirstCard[s] || h.SectionCards[s] != TLIBinarySectionCards[s]) return false;
+			PerDay += h.SectionCards[s];
+		}
+		if ((uint64_t)h.Days * PerDay != h.Cards) return false;
+		return (uint64_t)Size == sizeof(TLIBinaryHeader) + (uint64_t)h.Cards * sizeof(TLIBinaryCard);
+	}
+
+	const char *Ptr;
+	size_t Size;
+};
@@ -0,0 +1,4198 @@
+/***************************************************************************
+  This file is part of Project Apollo - NASSP
+  Copyright (c) 2022 Niklas Beug
+
+  RTCC TLI presettings converter
+
+  Project Apollo is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Project Apollo is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Project Apollo; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  See http://nassp.sourceforge.net/license/ for more details.
+
+  **************************************************************************/
+
+#include "RTCC_TLI_Presettings.h"
+#include "RTCC_TLI_BinaryDeck.h"
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <sstream>
+#include <utility>
+#include <charconv>
+#include <deque>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <zlib.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+//io_uring through its system calls, no liburing needed
+#define SCENARIO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define SCANNER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+constexpr double R_Earth = 6378165.0;
+constexpr double PI = 3.14159265358979323846;
+constexpr double RAD = PI / 180.0;
+constexpr double HRS = 3600.0;
+constexpr double ER2HR2ToM2SEC2 = (R_Earth / 3600.0) * (R_Earth / 3600.0);
+constexpr double LBS = 0.45359237;
+constexpr double DT_GRR = 17.0;
+constexpr double MU_Earth = 3.986032e14;
+
+constexpr FieldDesc Val(const LVDCKey &key, double defval, FieldConv conv = FieldConv::None, int ref = 0)
+{
+	return FieldDesc{ FieldType::Value, key, defval, conv, ref };
+}
+
+constexpr FieldDesc LaunchDayField()
+{
+	return FieldDesc{ FieldType::LaunchDay, LVDCKey{}, 0.0, FieldConv::None, 0 };
+}
+
+constexpr FieldDesc OppField()
+{
+	return FieldDesc{ FieldType::Opp, LVDCKey{}, 0.0, FieldConv::None, 0 };
+}
+
+constexpr std::array<CardDesc, 46> MakeSection1()
+{
+	//Cards 1 - 460
+
+	std::array<CardDesc, 46> cards{};
+	size_t n = 0;
+
+	for (int opp = 1; opp <= 2; opp++)
+	{
+		char o = opp == 1 ? 'A' : 'B';
+
+		//Card 1, 24
+		cards[n++] = { opp, { LaunchDayField(), OppField(), Val(MakeKey("LVDC_TP", o, 0), -1.0, FieldConv::DivHRS), Val(MakeKey("LVDC_COS", o, 0), -1.0) } };
+		//Card 2, 25
+		cards[n++] = { opp, { Val(MakeKey("LVDC_C3", o, 0), -1.0, FieldConv::DivER2HR2), Val(MakeKey("LVDC_EN", o, 0), -1.0),
+			Val(MakeKey("LVDC_RAS", o, 0), -1.0, FieldConv::MulRAD), Val(MakeKey("LVDC_DEC", o, 0), -1.0, FieldConv::MulRAD) } };
+
+		for (int k = 0; k < 7; k++)
+		{
+			//Card 3, 6...
+			cards[n++] = { opp, { Val(MakeKey("LVDC_TP", o, 2 * k + 1), 1000.0, FieldConv::DivHRS), Val(MakeKey("LVDC_COS", o, 2 * k + 1), 9.958662e-1),
+				Val(MakeKey("LVDC_C3", o, 2 * k + 1), -1.418676e6, FieldConv::DivER2HR2), Val(MakeKey("LVDC_EN", o, 2 * k + 1), 0.9765500) } };
+			//Card 4, 7...
+			cards[n++] = { opp, { Val(MakeKey("LVDC_RAS", o, 2 * k + 1), -114.382494, FieldConv::MulRAD), Val(MakeKey("LVDC_DEC", o, 2 * k + 1), -26.646912, FieldConv::MulRAD),
+				Val(MakeKey("LVDC_TP", o, 2 * k + 2), 1000.0, FieldConv::DivHRS), Val(MakeKey("LVDC_COS", o, 2 * k + 2), 9.958662e-1) } };
+			//Card 5, 8...
+			cards[n++] = { opp, { Val(MakeKey("LVDC_C3", o, 2 * k + 2), -1.418676e6, FieldConv::DivER2HR2), Val(MakeKey("LVDC_EN", o, 2 * k + 2), 0.9765500),
+				Val(MakeKey("LVDC_RAS", o, 2 * k + 2), -114.382494, FieldConv::MulRAD), Val(MakeKey("LVDC_DEC", o, 2 * k + 2), -26.646912, FieldConv::MulRAD) } };
+		}
+	}
+	return cards;
+}
+
+constexpr std::array<CardDesc, 8> MakeSection2()
+{
+	//Cards 461 - 540
+
+	std::array<CardDesc, 8> cards{};
+	size_t n = 0;
+
+	for (int opp = 1; opp <= 2; opp++)
+	{
+		char o = opp == 1 ? 'A' : 'B';
+
+		//Card 461, 465
+		cards[n++] = { opp, { LaunchDayField(), OppField(), Val(MakeKey("LVDC_TST", o), 15000.0, FieldConv::DivHRS), Val(MakeKey("LVDC_BETA", o), 61.89975, FieldConv::MulRAD) } };
+		//Card 462, 466
+		cards[n++] = { opp, { Val(MakeKey("LVDC_ALFTS", o), 14.2691472, FieldConv::MulRAD), Val(MakeKey("LVDC_F", o), 14.26968, FieldConv::MulRAD),
+			Val(MakeKey("LVDC_RN", o), 6575100.0, FieldConv::DivR_Earth), Val(MakeKey("LVDC_T3PR", o), 310.8243, FieldConv::DivHRS) } };
+		//Card 463, 467
+		cards[n++] = { opp, { Val(MakeKey("LVDC_TAU3R", o), opp == 1 ? 684.5038 : 682.1127, FieldConv::DivHRS), Val(opp == 1 ? MakeKey("LVDC_T2IR") : MakeKey("LVDC_T2IR", o), 10.0, FieldConv::DivHRS),
+			Val(MakeKey("LVDC_V_ex2R"), 4221.827032, FieldConv::DivR_EarthMulHRS), Val(MakeKey("LVDC_dotM_2R"), 215.2241, FieldConv::DivLBSMulHRS) } };
+		//Card 464, 468
+		cards[n++] = { opp, { Val(MakeKey("LVDC_DVBR", o), 3.7, FieldConv::MulHRSDivR_Earth), Val(MakeKey("LVDC_tau2N"), 721.0, FieldConv::DivHRS),
+			Val(MakeKey("LVDC_K_P1"), 0.0), Val(MakeKey("LVDC_K_Y1"), 0.0) } };
+	}
+	return cards;
+}
+
+//Cards 1 - 460
+constexpr std::array<CardDesc, 46> Section1Cards = MakeSection1();
+//Cards 461 - 540
+constexpr std::array<CardDesc, 8> Section2Cards = MakeSection2();
+//Cards 541 - 620. This section is actually opportunity independent
+constexpr std::array<CardDesc, 8> Section3Cards =
+{ {
+	//Card 541
+	{ 2, { LaunchDayField(), Val(MakeKey("LVDC_T_LO"), 0.0, FieldConv::GRRTime), Val(MakeKey("LVDC_THTEO"), 0.0, FieldConv::GRRAngle, 3), Val(MakeKey("LVDC_omega_E"), 7.292107788e-5, FieldConv::MulHRS) } },
+	//Card 542
+	{ 2, { Val(MakeKey("LVDC_K_a1"), 0.0, FieldConv::MulHRS), Val(MakeKey("LVDC_K_a2"), 0.0, FieldConv::MulHRS2), Val(MakeKey("LVDC_K_T3"), -.274), Val(MakeKey("LVDC_t_DS0"), 0.0, FieldConv::MulHRS) } },
+	//Card 543
+	{ 2, { Val(MakeKey("LVDC_t_DS1"), 10984.2, FieldConv::DivHRS), Val(MakeKey("LVDC_t_DS2"), 16503.1, FieldConv::DivHRS), Val(MakeKey("LVDC_t_DS3"), 0.0, FieldConv::DivHRS), Val(MakeKey("LVDC_hx[0][0]"), 72.0, FieldConv::MulRAD) } },
+	//Card 544
+	{ 2, { Val(MakeKey("LVDC_hx[0][1]"), 0.0, FieldConv::MulRAD), Val(MakeKey("LVDC_hx[0][2]"), 0.0, FieldConv::MulRAD), Val(MakeKey("LVDC_hx[0][3]"), 0.0, FieldConv::MulRAD), Val(MakeKey("LVDC_hx[0][4]"), 0.0, FieldConv::MulRAD) } },
+	//Card 545
+	{ 2, { Val(MakeKey("LVDC_t_D1"), 0.0, FieldConv::DivHRS), Val(MakeKey("LVDC_t_SD1"), 10984.2, FieldConv::DivHRS), Val(MakeKey("LVDC_hx[1][0]"), 72.0, FieldConv::MulRAD), Val(MakeKey("LVDC_hx[1][1]"), 0.0, FieldConv::MulRAD) } },
+	//Card 546
+	{ 2, { Val(MakeKey("LVDC_hx[1][2]"), 0.0, FieldConv::MulRAD), Val(MakeKey("LVDC_hx[1][3]"), 0.0, FieldConv::MulRAD), Val(MakeKey("LVDC_hx[1][4]"), 0.0, FieldConv::MulRAD), Val(MakeKey("LVDC_t_D2"), 10984.2, FieldConv::DivHRS) } },
+	//Card 547
+	{ 2, { Val(MakeKey("LVDC_t_SD2"), 5518.9, FieldConv::DivHRS), Val(MakeKey("LVDC_hx[2][0]"), 72.0, FieldConv::MulRAD), Val(MakeKey("LVDC_hx[2][1]"), 0.0, FieldConv::MulRAD), Val(MakeKey("LVDC_hx[2][2]"), 0.0, FieldConv::MulRAD) } },
+	//Card 548
+	{ 2, { Val(MakeKey("LVDC_hx[2][3]"), 0.0, FieldConv::MulRAD), Val(MakeKey("LVDC_hx[2][4]"), 0.0, FieldConv::MulRAD), Val(MakeKey("LVDC_t_D3"), 16503.1, FieldConv::DivHRS), Val(MakeKey("LVDC_t_SD3"), 1233.6, FieldConv::DivHRS) } },
+} };
+
+constexpr int SectionFirstCard[3] = { 1, 461, 541 };
+const CardDesc *const SectionLayout[3] = { Section1Cards.data(), Section2Cards.data(), Section3Cards.data() };
+constexpr size_t SectionSize[3] = { Section1Cards.size(), Section2Cards.size(), Section3Cards.size() };
+
+//Schema of the LVDC presettings, with a perfect hash built at compile time. A scanned key maps to its schema index
+//with two hashes and one compare, any other LVDC_ key is rejected.
+
+constexpr size_t LayoutCards = Section1Cards.size() + Section2Cards.size() + Section3Cards.size();
+
+//Field f of card i, counting through all three sections
+constexpr const FieldDesc &LayoutField(size_t i, int f)
+{
+	return i < Section1Cards.size() ? Section1Cards[i].Field[f] :
+		i < Section1Cards.size() + Section2Cards.size() ? Section2Cards[i - Section1Cards.size()].Field[f] :
+		Section3Cards[i - Section1Cards.size() - Section2Cards.size()].Field[f];
+}
+
+//Longest key. All keys start with LVDC_, the rest fits into 8 bytes.
+constexpr size_t SchemaKeyLen = 13;
+
+//Key without the LVDC_, packed into a word
+constexpr uint64_t PackKey(const char *p, size_t len)
+{
+	uint64_t w = 0;
+	for (size_t i = 5; i < len; i++) w |= (uint64_t)(unsigned char)p[i] << (8 * (i - 5));
+	return w;
+}
+
+constexpr uint32_t SchemaHash(uint64_t w, size_t len, uint32_t seed)
+{
+	w += len * 0x9E3779B97F4A7C15ULL + seed * 0xC2B2AE3D27D4EB4FULL;
+	w ^= w >> 33;
+	w *= 0xFF51AFD7ED558CCDULL;
+	w ^= w >> 33;
+	w *= 0xC4CEB9FE1A85EC53ULL;
+	w ^= w >> 33;
+	return (uint32_t)w;
+}
+
+//Buckets of the first hash, and slots of the second
+constexpr uint32_t SchemaBuckets = 64;
+constexpr uint32_t SchemaSlots = 512;
+
+//Seed of the second hash for each bucket, chosen so that no two keys share a slot. Searching them at compile time
+//takes more constant evaluation steps than compilers allow by default, so they are found offline: after adding or
+//changing keys, build with TLI_SCHEMA_SEEDS defined and run the converter, it prints the new table and exits.
+//MakeSchemaSlots checks that the seeds still place every key in a slot of its own.
+constexpr uint32_t SchemaSeeds[SchemaBuckets] =
+{
+	2, 1, 4, 2, 2, 2, 5, 4, 3, 3, 2, 2, 5, 6, 1, 3,
+	3, 8, 3, 1, 2, 4, 4, 1, 10, 1, 2, 2, 11, 7, 1, 2,
+	5, 1, 12, 2, 1, 3, 2, 2, 2, 1, 4, 6, 0, 5, 0, 3,
+	6, 3, 4, 2, 15, 2, 1, 1, 1, 4, 3, 1, 2, 1, 10, 3,
+};
+
+//At most one key per field
+constexpr size_t SchemaCapacity = LayoutCards * 4;
+
+struct SchemaTable
+{
+	//Number of keys
+	size_t Count;
+	//Packed keys and their lengths, by schema index
+	uint64_t Word[SchemaCapacity];
+	uint8_t Len[SchemaCapacity];
+	//First field with the key, for the default and conversion
+	const FieldDesc *Desc[SchemaCapacity];
+	//Schema index + 1 of each key by the slot of the first hash, with linear probing, to find repeated keys
+	uint16_t Seen[SchemaSlots];
+};
+
+//Adds the keys of cards first to last - 1 that aren't in the schema yet, in layout order
+constexpr SchemaTable AddSchemaKeys(SchemaTable t, size_t first, size_t last)
+{
+	for (size_t i = first; i < last; i++)
+	{
+		for (int f = 0; f < 4; f++)
+		{
+			const FieldDesc &field = LayoutField(i, f);
+			if (field.Type != FieldType::Value) continue;
+			const char *k = field.Key.Str;
+			if (field.Key.Len <= 5 || field.Key.Len > SchemaKeyLen || k[0] != 'L' || k[1] != 'V' || k[2] != 'D' || k[3] != 'C' || k[4] != '_') throw "Key doesn't fit the schema";
+
+			uint64_t w = PackKey(k, field.Key.Len);
+			uint32_t p = SchemaHash(w, field.Key.Len, 0) % SchemaSlots;
+			while (t.Seen[p] != 0 && (t.Word[t.Seen[p] - 1] != w || t.Len[t.Seen[p] - 1] != field.Key.Len)) p = (p + 1) % SchemaSlots;
+			if (t.Seen[p] != 0)
+			{
+				//The store has one column per key
+				const FieldDesc *desc = t.Desc[t.Seen[p] - 1];
+				if (desc->Default != field.Default || desc->Conv != field.Conv) throw "Key with two defaults or conversions";
+				continue;
+			}
+			t.Seen[p] = (uint16_t)(t.Count + 1);
+
+			t.Word[t.Count] = w;
+			t.Len[t.Count] = (uint8_t)field.Key.Len;
+			t.Desc[t.Count] = &field;
+			t.Count++;
+		}
+	}
+	return t;
+}
+
+//The keys are collected a few cards at a time, each step its own constant evaluation, so that none of them comes near
+//the step limits of the compilers
+constexpr SchemaTable SchemaStep1 = AddSchemaKeys(SchemaTable{}, 0, 16);
+constexpr SchemaTable SchemaStep2 = AddSchemaKeys(SchemaStep1, 16, 32);
+constexpr SchemaTable SchemaStep3 = AddSchemaKeys(SchemaStep2, 32, 48);
+constexpr SchemaTable Schema = AddSchemaKeys(SchemaStep3, 48, LayoutCards);
+constexpr size_t SchemaSize = Schema.Count;
+
+struct SchemaSlotTable
+{
+	//Schema index + 1 of each slot, 0 for an empty slot
+	uint16_t Slot[SchemaSlots];
+};
+
+//Places the keys with SchemaSeeds. Built on its own, so that neither this nor MakeSchema comes near the step limits of
+//constant evaluation.
+constexpr SchemaSlotTable MakeSchemaSlots()
+{
+	SchemaSlotTable t{};
+
+#ifndef TLI_SCHEMA_SEEDS
+	for (size_t i = 0; i < Schema.Count; i++)
+	{
+		uint32_t b = SchemaHash(Schema.Word[i], Schema.Len[i], 0) % SchemaBuckets;
+		uint32_t slot = SchemaHash(Schema.Word[i], Schema.Len[i], SchemaSeeds[b]) % SchemaSlots;
+		if (t.Slot[slot] != 0) throw "Two keys share a slot, the schema seeds have to be found again";
+		t.Slot[slot] = (uint16_t)(i + 1);
+	}
+#endif
+	return t;
+}
+
+constexpr SchemaSlotTable SchemaSlotMap = MakeSchemaSlots();
+
+//Schema index of a key that starts with LVDC_, or -1
+constexpr int SchemaLookup(const char *key, size_t len)
+{
+	//Quick length check, before any hashing
+	if (len <= 5 || len > SchemaKeyLen) return -1;
+
+	uint64_t w = PackKey(key, len);
+#ifdef TLI_SCHEMA_SEEDS
+	//Without the right seeds the slots are empty, look through all keys
+	for (size_t i = 0; i < Schema.Count; i++)
+	{
+		if (Schema.Word[i] == w && Schema.Len[i] == len) return (int)i;
+	}
+	return -1;
+#else
+	uint32_t b = SchemaHash(w, len, 0) % SchemaBuckets;
+	int i = (int)SchemaSlotMap.Slot[SchemaHash(w, len, SchemaSeeds[b]) % SchemaSlots] - 1;
+	if (i < 0 || Schema.Word[i] != w || Schema.Len[i] != len) return -1;
+	return i;
+#endif
+}
+
+#ifdef TLI_SCHEMA_SEEDS
+//Finds the seeds for SchemaSeeds and prints them before main runs. The largest buckets are placed first, they are the
+//hardest to fit, then each bucket takes the smallest seed that puts its keys into free slots.
+static int PrintSchemaSeeds()
+{
+	std::vector<std::vector<uint32_t>> keys(SchemaBuckets);
+	for (uint32_t i = 0; i < Schema.Count; i++) keys[SchemaHash(Schema.Word[i], Schema.Len[i], 0) % SchemaBuckets].push_back(i);
+
+	std::vector<uint32_t> order(SchemaBuckets);
+	for (uint32_t b = 0; b < SchemaBuckets; b++) order[b] = b;
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a].size() > keys[b].size(); });
+
+	std::vector<bool> used(SchemaSlots);
+	uint32_t seeds[SchemaBuckets] = {};
+	for (uint32_t b : order)
+	{
+		std::vector<uint32_t> slot(keys[b].size());
+		for (uint32_t seed = keys[b].empty() ? 0 : 1;; seed++)
+		{
+			if (seed > 1000000)
+			{
+				std::cerr << "No seed found for bucket " << b << ", try more slots" << std::endl;
+				std::exit(1);
+			}
+
+			bool free = true;
+			for (size_t k = 0; k < keys[b].size() && free; k++)
+			{
+				slot[k] = SchemaHash(Schema.Word[keys[b][k]], Schema.Len[keys[b][k]], seed) % SchemaSlots;
+				free = !used[slot[k]] && std::find(slot.begin(), slot.begin() + k, slot[k]) == slot.begin() + k;
+			}
+			if (free == false) continue;
+
+			seeds[b] = seed;
+			for (uint32_t sl : slot) used[sl] = true;
+			break;
+		}
+	}
+
+	for (uint32_t b = 0; b < SchemaBuckets; b++) std::cout << (b % 16 == 0 ? "\t" : " ") << seeds[b] << "," << (b % 16 == 15 ? "\n" : "");
+	std::exit(0);
+}
+
+static const int SchemaSeedsPrinted = PrintSchemaSeeds();
+#endif
+
+constexpr size_t SectionStart[3] = { 0, Section1Cards.size(), Section1Cards.size() + Section2Cards.size() };
+
+//Schema indices of the card fields
+struct SchemaFieldTable
+{
+	//Key of field f of card i, counting through all sections. -1 for fields without a presetting.
+	int16_t Key[LayoutCards][4];
+	//Key of the second input of a conversion, -1 for none
+	int16_t Ref[SchemaCapacity];
+};
+
+constexpr SchemaFieldTable MakeSchemaFields()
+{
+	SchemaFieldTable t{};
+
+	for (size_t k = 0; k < SchemaCapacity; k++) t.Ref[k] = -1;
+	for (size_t i = 0; i < LayoutCards; i++)
+	{
+		for (int f = 0; f < 4; f++)
+		{
+			const FieldDesc &field = LayoutField(i, f);
+			t.Key[i][f] = field.Type == FieldType::Value ? (int16_t)SchemaLookup(field.Key.Str, field.Key.Len) : -1;
+			if (field.Type == FieldType::Value && field.Conv == FieldConv::GRRAngle)
+			{
+				const FieldDesc &ref = LayoutField(i, field.Ref);
+				t.Ref[t.Key[i][f]] = (int16_t)SchemaLookup(ref.Key.Str, ref.Key.Len);
+			}
+		}
+	}
+	return t;
+}
+
+constexpr SchemaFieldTable SchemaFields = MakeSchemaFields();
+
+constexpr PresettingRule RangeRule(const LVDCKey &key, double lo, double hi)
+{
+	int k = SchemaLookup(key.Str, key.Len);
+	if (k < 0) throw "Rule for a key that isn't in the schema";
+	return PresettingRule{ RuleKind::Range, k, -1, lo, hi };
+}
+
+constexpr PresettingRule OrderRule(const LVDCKey &key, const LVDCKey &key2)
+{
+	int k = SchemaLookup(key.Str, key.Len), k2 = SchemaLookup(key2.Str, key2.Len);
+	if (k < 0 || k2 < 0) throw "Rule for a key that isn't in the schema";
+	return PresettingRule{ RuleKind::Order, k, k2, 0.0, 0.0 };
+}
+
+//Finite, then per opportunity 15 COS, 14 TP and 4 * 14 target rules, then section 3
+constexpr size_t RuleCount = 1 + 2 * (15 + 14 + 4 * 14) + 6;
+
+constexpr std::array<PresettingRule, RuleCount> MakeRules()
+{
+	std::array<PresettingRule, RuleCount> rules{};
+	constexpr double Max = std::numeric_limits<double>::max();
+	size_t n = 0;
+
+	rules[n++] = { RuleKind::Finite, -1, -1, 0.0, 0.0 };
+
+	for (int opp = 1; opp <= 2; opp++)
+	{
+		char o = opp == 1 ? 'A' : 'B';
+
+		//Cosine of the target angle
+		for (int i = 0; i < 15; i++) rules[n++] = RangeRule(MakeKey("LVDC_COS", o, i), -1.0, 1.0);
+		//Times of the launch window table increase
+		for (int i = 1; i < 15; i++) rules[n++] = OrderRule(MakeKey("LVDC_TP", o, i - 1), MakeKey("LVDC_TP", o, i));
+		//Targets of index 0 are -1 placeholders. The others are bound orbits above the surface, with eccentricity up
+		//to 1 and the direction in degrees.
+		for (int i = 1; i < 15; i++)
+		{
+			rules[n++] = RangeRule(MakeKey("LVDC_C3", o, i), -2.0 * MU_Earth / R_Earth, 0.0);
+			rules[n++] = RangeRule(MakeKey("LVDC_EN", o, i), 0.0, 1.0);
+			rules[n++] = RangeRule(MakeKey("LVDC_RAS", o, i), -360.0, 360.0);
+			rules[n++] = RangeRule(MakeKey("LVDC_DEC", o, i), -90.0, 90.0);
+		}
+	}
+
+	//Launch window segments
+	rules[n++] = OrderRule(MakeKey("LVDC_t_DS1"), MakeKey("LVDC_t_DS2"));
+	rules[n++] = OrderRule(MakeKey("LVDC_t_D1"), MakeKey("LVDC_t_D2"));
+	rules[n++] = OrderRule(MakeKey("LVDC_t_D2"), MakeKey("LVDC_t_D3"));
+	rules[n++] = RangeRule(MakeKey("LVDC_t_SD1"), 0.0, Max);
+	rules[n++] = RangeRule(MakeKey("LVDC_t_SD2"), 0.0, Max);
+	rules[n++] = RangeRule(MakeKey("LVDC_t_SD3"), 0.0, Max);
+
+	if (n != RuleCount) throw "Wrong number of rules";
+	return rules;
+}
+
+constexpr std::array<PresettingRule, RuleCount> PresettingRules = MakeRules();
+
+//One operation of a unit conversion
+struct ConvStep
+{
+	//'*', '/' or '+', 0 for none
+	char Op;
+	double C;
+};
+
+//Conversion of a LVDC presetting to RTCC units, as operations in the order they are done. The SIMD passes do exactly
+//these, so the result is the same bit for bit on any CPU. GRRAngle also needs the presetting of field Ref, it is done
+//as value + DT_GRR * ref.
+constexpr std::array<ConvStep, 2> ConvSteps(FieldConv Conv)
+{
+	switch (Conv)
+	{
+	case FieldConv::DivHRS:
+		return { { { '/', HRS }, { 0, 0.0 } } };
+	case FieldConv::MulHRS:
+		return { { { '*', HRS }, { 0, 0.0 } } };
+	case FieldConv::MulHRS2:
+		return { { { '*', HRS * HRS }, { 0, 0.0 } } };
+	case FieldConv::MulRAD:
+		return { { { '*', RAD }, { 0, 0.0 } } };
+	case FieldConv::DivER2HR2:
+		return { { { '/', ER2HR2ToM2SEC2 }, { 0, 0.0 } } };
+	case FieldConv::DivR_Earth:
+		return { { { '/', R_Earth }, { 0, 0.0 } } };
+	case FieldConv::DivR_EarthMulHRS:
+		return { { { '/', R_Earth }, { '*', HRS } } };
+	case FieldConv::MulHRSDivR_Earth:
+		return { { { '*', HRS }, { '/', R_Earth } } };
+	case FieldConv::DivLBSMulHRS:
+		return { { { '/', LBS }, { '*', HRS } } };
+	case FieldConv::GRRTime:
+		return { { { '+', DT_GRR }, { '/', HRS } } };
+	default:
+		return { { { 0, 0.0 }, { 0, 0.0 } } };
+	}
+}
+
+//Converts a card field back to the LVDC presetting, the reverse of ConvSteps. raw[Ref] has to be converted first.
+inline double RevertField(FieldConv Conv, const double val[4], const double raw[4], int f, int Ref)
+{
+	switch (Conv)
+	{
+	case FieldConv::DivHRS:
+		return val[f] * HRS;
+	case FieldConv::MulHRS:
+		return val[f] / HRS;
+	case FieldConv::MulHRS2:
+		return val[f] / (HRS * HRS);
+	case FieldConv::MulRAD:
+		return val[f] / RAD;
+	case FieldConv::DivER2HR2:
+		return val[f] * ER2HR2ToM2SEC2;
+	case FieldConv::DivR_Earth:
+		return val[f] * R_Earth;
+	case FieldConv::DivR_EarthMulHRS:
+		return val[f] * R_Earth / HRS;
+	case FieldConv::MulHRSDivR_Earth:
+		return val[f] / HRS * R_Earth;
+	case FieldConv::DivLBSMulHRS:
+		return val[f] * LBS / HRS;
+	case FieldConv::GRRTime:
+		return val[f] * HRS - DT_GRR;
+	case FieldConv::GRRAngle:
+		return val[f] - DT_GRR * raw[Ref];
+	default:
+		return val[f];
+	}
+}
+
+//Change of the card field per unit of the presetting
+inline double FieldScale(FieldConv Conv)
+{
+	switch (Conv)
+	{
+	case FieldConv::DivHRS:
+	case FieldConv::GRRTime:
+		return 1.0 / HRS;
+	case FieldConv::MulHRS:
+		return HRS;
+	case FieldConv::MulHRS2:
+		return HRS * HRS;
+	case FieldConv::MulRAD:
+		return RAD;
+	case FieldConv::DivER2HR2:
+		return 1.0 / ER2HR2ToM2SEC2;
+	case FieldConv::DivR_Earth:
+		return 1.0 / R_Earth;
+	case FieldConv::DivR_EarthMulHRS:
+	case FieldConv::MulHRSDivR_Earth:
+		return HRS / R_Earth;
+	case FieldConv::DivLBSMulHRS:
+		return HRS / LBS;
+	default:
+		return 1.0;
+	}
+}
+
+//Takes the cards of a scenario from the cache if it has them, returns false if not. Key is the cache key.
+static bool FindCached(const ScenarioIndex &in, int LaunchDay, ScenarioCards &cards, CardCache &cache, uint64_t &Key, RunStats *stats)
+{
+	cards.Errors.clear();
+
+	//Same presettings and launch day give the same cards
+	Key = CardCache::Key(in.ContentHash(), LaunchDay);
+	if (cache.Find(Key, cards))
+	{
+		if (stats) stats->CacheHits++;
+		return true;
+	}
+	if (stats && cache.Enabled()) stats->CacheMisses++;
+	return false;
+}
+
+bool GenerateDecks(const std::vector<DeckJob> &Jobs, ThreadPool &pool, CardCache &cache, RunStats *stats, const DeckWriteOptions &Write)
+{
+	//Launch days of all decks, read in parallel
+	std::vector<DeckTask> Tasks;
+	//First task of each deck, the tasks of a deck are contiguous
+	std::vector<size_t> FirstTask(Jobs.size() + 1);
+	std::vector<ScenarioCards> Cards;
+	std::string out;
+	bool ok = true;
+	bool ToStdout = false;
+
+	for (size_t j = 0; j < Jobs.size(); j++)
+	{
+		if (Jobs[j].FileNameOut == StdStream) ToStdout = true;
+
+		FirstTask[j] = Tasks.size();
+		for (size_t i = 0; i < Jobs[j].FileNameInArr.size(); i++)
+		{
+			Tasks.push_back({ Jobs[j].FileNameInArr[i], Jobs[j].LaunchDayArr[i] });
+		}
+	}
+	FirstTask[Jobs.size()] = Tasks.size();
+
+	//Each scenario is opened and parsed once, for all three sections. The presettings of all launch days go into one store,
+	//which converts them in one pass. The files are read ahead while the workers parse.
+	std::vector<std::string> Files(Tasks.size());
+	for (size_t i = 0; i < Tasks.size(); i++) Files[i] = Tasks[i].FileName;
+	Cards.resize(Tasks.size());
+	std::vector<RunStats> TaskStats(stats ? Tasks.size() : 0);
+	std::vector<uint64_t> CacheKey(Tasks.size());
+	std::vector<char> Cached(Tasks.size());
+	PresettingStore store;
+	store.Reset(Tasks.size());
+	ScenarioReader::Read(Files, pool, [&](size_t i, const std::string *Data)
+	{
+		ScenarioArena &arena = pool.Arena();
+		uint64_t allocs = arena.HeapAllocs();
+		RunStats *st = stats ? &TaskStats[i] : nullptr;
+		{
+			ArenaScope scope(arena);
+			ScenarioIndex in(arena.Resource());
+
+			if (Data) Cards[i].Found = in.LoadRead(*Data, st);
+			else Cards[i].Found = Tasks[i].FileName == StdStream ? in.LoadStream(stdin, st) : in.Load(Tasks[i].FileName, st);
+			if (Cards[i].Found)
+			{
+				Cached[i] = FindCached(in, Tasks[i].LaunchDay, Cards[i], cache, CacheKey[i], st);
+				if (Cached[i] == false) store.Extract(i, in, Cards[i].Errors, st);
+			}
+		}
+		if (st) st->ArenaAllocs += arena.HeapAllocs() - allocs;
+	});
+
+	store.Convert(stats);
+
+	//Shared by all decks, missions have many presettings in common as well
+	CardInterner intern;
+	pool.Run(Tasks.size(), [&](size_t i)
+	{
+		if (Cards[i].Found == false || Cached[i]) return;
+		store.Render(i, Tasks[i].LaunchDay, Cards[i], &intern, stats ? &TaskStats[i] : nullptr);
+		if (Cards[i].Errors.empty()) cache.Insert(CacheKey[i], Cards[i]);
+	});
+
+	if (stats)
+	{
+		for (size_t i = 0; i < Tasks.size(); i++)
+		{
+			stats->Add(TaskStats[i]);
+			stats->Scenarios++;
+			if (Cards[i].Found == false || Cards[i].Errors.empty() == false) stats->ScenariosFailed++;
+		}
+		stats->Decks += (unsigned)Jobs.size();
+	}
+
+	//Messages must not end up in a deck written to stdout
+	std::ostream &log = ToStdout ? std::cerr : std::cout;
+
+	for (size_t j = 0; j < Jobs.size(); j++)
+	{
+		//Don't write an incomplete deck, or one with defaults in place of malformed values
+		bool missing = false;
+		for (size_t i = FirstTask[j]; i < FirstTask[j + 1]; i++)
+		{
+			if (Cards[i].Found == false)
+			{
+				log << "File " << Tasks[i].FileName << " not found!" << std::endl;
+				missing = true;
+			}
+			for (size_t k = 0; k < Cards[i].Errors.size(); k++)
+			{
+				const ScenarioError &err = Cards[i].Errors[k];
+				log << "File " << Tasks[i].FileName << " line " << err.Line << " column " << err.Column << ": " << err.Key << " is not a number!" << std::endl;
+				missing = true;
+			}
+		}
+		if (missing)
+		{
+			log << "File " << Jobs[j].FileNameOut << " not generated!" << std::endl;
+			if (stats) stats->DecksFailed++;
+			ok = false;
+			continue;
+		}
+
+		for (size_t i = FirstTask[j]; i < FirstTask[j + 1]; i++)
+		{
+			log << "Process file " << Tasks[i].FileName << std::endl;
+		}
+
+		double start = stats ? StatsClock() : 0.0;
+		bool written;
+		std::string Error;
+
+		if (Write.Patch)
+		{
+			written = PatchDeck(Jobs[j], &Cards[FirstTask[j]], Error);
+		}
+		else
+		{
+			out.clear();
+			written = WriteDeck(Jobs[j], &Cards[FirstTask[j]], out, Error);
+			if (written) written = (Jobs[j].FileNameOut == StdStream ? WriteStream(stdout, out) : WriteFileAtomic(Jobs[j].FileNameOut, out));
+		}
+		//From the same cards as the text deck
+		bool BinaryWritten = true;
+		if (written && Write.Binary && Jobs[j].FileNameOut != StdStream)
+		{
+			out.clear();
+			BinaryWritten = WriteBinaryDeck(Jobs[j], &Cards[FirstTask[j]], out, Error) && WriteFileAtomic(Jobs[j].FileNameOut + ".bin", out);
+		}
+
+		if (stats)
+		{
+			stats->Write += StatsClock() - start;
+			if (written == false) stats->DecksFailed++;
+			for (size_t i = FirstTask[j]; i < FirstTask[j + 1] && written; i++)
+			{
+				for (int s = 0; s < 3; s++) stats->Cards[s] += Cards[i].Section[s].size();
+			}
+		}
+
+		if (written == false)
+		{
+			if (Write.Patch) log << "File " << Jobs[j].FileNameOut << " can't be patched: " << Error << "!" << std::endl;
+			else if (Error.empty() == false) log << "File " << Jobs[j].FileNameOut << " not generated: " << Error << "!" << std::endl;
+			else log << "File " << Jobs[j].FileNameOut << " can't be written!" << std::endl;
+			ok = false;
+			continue;
+		}
+		log << "File " << Jobs[j].FileNameOut << (Write.Patch ? " patched!" : " generated!") << std::endl;
+		if (BinaryWritten == false)
+		{
+			log << "File " << Jobs[j].FileNameOut << ".bin can't be written!" << std::endl;
+			if (stats) stats->DecksFailed++;
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+//Compares one deck with its scenarios, the messages go to Log
+static bool VerifyDeck(const DeckJob &job, std::string &Log, ScenarioArena &arena)
+{
+	std::ostringstream msg;
+	TLIDeck deck;
+	double val;
+	bool match = true;
+
+	msg.precision(9);
+
+	if (deck.Load(job.FileNameOut) == false)
+	{
+		msg << "File " << job.FileNameOut;
+		if (deck.ErrorLine) msg << " line " << deck.ErrorLine;
+		msg << ": " << deck.Error << "!" << std::endl;
+		Log = msg.str();
+		return false;
+	}
+	if (deck.Days() != job.FileNameInArr.size())
+	{
+		msg << "File " << job.FileNameOut << " has " << deck.Days() << " launch days instead of " << job.FileNameInArr.size() << "!" << std::endl;
+		match = false;
+	}
+	if (deck.Cards().front().Year != job.Year % 100)
+	{
+		msg << "File " << job.FileNameOut << " is for year " << deck.Cards().front().Year << " instead of " << job.Year % 100 << "!" << std::endl;
+		match = false;
+	}
+
+	for (size_t i = 0; i < deck.Days() && i < job.FileNameInArr.size(); i++)
+	{
+		const std::string &FileName = job.FileNameInArr[i];
+		ArenaScope scope(arena);
+		ScenarioIndex in(arena.Resource());
+
+		if (deck.LaunchDay(i) != job.LaunchDayArr[i])
+		{
+			msg << "File " << job.FileNameOut << " has launch day " << deck.LaunchDay(i) << " instead of " << job.LaunchDayArr[i] << "!" << std::endl;
+			match = false;
+		}
+		if ((FileName == StdStream ? in.LoadStream(stdin) : in.Load(FileName)) == false)
+		{
+			msg << "File " << FileName << " not found!" << std::endl;
+			match = false;
+			continue;
+		}
+
+		const std::vector<DeckValue> &vals = deck.Presettings(i);
+
+		for (size_t k = 0; k < vals.size(); k++)
+		{
+			const DeckValue &v = vals[k];
+			std::string_view Key = v.Desc->Key.View();
+
+			if (SearchForDouble(in, Key, val, v.Desc->Default) == LookupStatus::Malformed)
+			{
+				unsigned Line, Column;
+				in.Locate(*in.Find(Key), Line, Column);
+				msg << "File " << FileName << " line " << Line << " column " << Column << ": " << Key << " is not a number!" << std::endl;
+				match = false;
+			}
+			else if (std::fabs(v.Value - val) > v.Tolerance)
+			{
+				msg << "File " << job.FileNameOut << " card " << v.Card << ": " << Key << " is " << v.Value << ", but " << val << " in " << FileName << "!" << std::endl;
+				match = false;
+			}
+		}
+	}
+
+	msg << "File " << job.FileNameOut << (match ? " matches its scenarios!" : " doesn't match its scenarios!") << std::endl;
+	Log = msg.str();
+	return match;
+}
+
+bool VerifyDecks(const std::vector<DeckJob> &Jobs, ThreadPool &pool)
+{
+	//Messages of each deck, printed in order when all are done
+	std::vector<std::string> Log(Jobs.size());
+	std::vector<char> Match(Jobs.size());
+	bool ok = true;
+
+	pool.Run(Jobs.size(), [&](size_t j)
+	{
+		Match[j] = VerifyDeck(Jobs[j], Log[j], pool.Arena());
+	});
+
+	for (size_t j = 0; j < Jobs.size(); j++)
+	{
+		std::cout << Log[j];
+		if (Match[j] == false) ok = false;
+	}
+	return ok;
+}
+
+void ReadScenario(const std::string &FileName, int LaunchDay, ScenarioCards &cards, CardCache &cache, CardInterner *intern, RunStats *stats, ScenarioArena *arena)
+{
+	uint64_t allocs = arena ? arena->HeapAllocs() : 0;
+	{
+		std::optional<ArenaScope> scope;
+		if (arena) scope.emplace(*arena);
+		ScenarioIndex in(arena ? arena->Resource() : std::pmr::get_default_resource());
+
+		cards.Found = FileName == StdStream ? in.LoadStream(stdin, stats) : in.Load(FileName, stats);
+		if (cards.Found) RenderScenario(in, LaunchDay, cards, cache, intern, stats);
+	}
+	if (arena && stats) stats->ArenaAllocs += arena->HeapAllocs() - allocs;
+}
+
+void RenderScenario(const ScenarioIndex &in, int LaunchDay, ScenarioCards &cards, CardCache &cache, CardInterner *intern, RunStats *stats)
+{
+	PresettingStore store(in.Memory());
+	uint64_t key;
+
+	if (FindCached(in, LaunchDay, cards, cache, key, stats)) return;
+
+	store.Reset(1);
+	store.Extract(0, in, cards.Errors, stats);
+	store.Convert(stats);
+	store.Render(0, LaunchDay, cards, intern, stats);
+
+	//Errors need the positions in the scenario, so these cards are made again each time
+	if (cards.Errors.empty()) cache.Insert(key, cards);
+}
+
+//Calls func for each card of a deck in deck order, with the card ID filled in.
+//The deck is ordered by section, then by launch day. Card numbers count up through the launch days of a section.
+//Returns false with Error set, before the first card, if a card ID doesn't fit into its 12 columns.
+template<class F>
+static bool ForEachDeckCard(int Year, const std::vector<int> &LaunchDayArr, const ScenarioCards *cards, std::string &Error, F func)
+{
+	CardRecord card;
+	char ID[32];
+	int cardnum;
+	size_t i, k;
+
+	//All IDs are checked before any card is passed on
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (int s = 0; s < 3; s++)
+		{
+			cardnum = SectionFirstCard[s];
+
+			for (i = 0; i < LaunchDayArr.size(); i++)
+			{
+				//Set up ID
+				snprintf(ID, sizeof(ID), "%02d%03d", Year % 100, LaunchDayArr[i]);
+
+				for (k = 0; k < cards[i].Section[s].size(); k++)
+				{
+					card = cards[i].Section[s][k];
+					if (FormatID(card.Text + 68, ID, card.Opp, cardnum) == false)
+					{
+						Error = "the ID of card " + std::to_string(cardnum) + " for launch day " + std::to_string(LaunchDayArr[i]) + " is wider than 12 columns";
+						return false;
+					}
+					if (pass == 1) func(card);
+					cardnum++;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+//Number of cards in a deck
+static size_t DeckSize(const ScenarioCards *cards, size_t Days)
+{
+	size_t n = 0;
+
+	for (size_t i = 0; i < Days; i++)
+	{
+		n += cards[i].Section[0].size() + cards[i].Section[1].size() + cards[i].Section[2].size();
+	}
+	return n;
+}
+
+//Text mode line ends, as the cards used to be written with std::endl
+#ifdef _WIN32
+const std::string_view CardEnd = "\r\n";
+#else
+const std::string_view CardEnd = "\n";
+#endif
+
+bool WriteDeck(const DeckJob &job, const ScenarioCards *cards, std::string &out, std::string &Error)
+{
+	out.reserve(out.size() + DeckSize(cards, job.LaunchDayArr.size()) * (80 + CardEnd.length()));
+
+	return ForEachDeckCard(job.Year, job.LaunchDayArr, cards, Error, [&](const CardRecord &card)
+	{
+		out.append(card.Text, 80);
+		out.append(CardEnd);
+	});
+}
+
+bool GenerateDeck(int Year, const std::vector<ScenarioInput> &Scenarios, DeckOutput &Deck, RunStats *stats)
+{
+	std::vector<ScenarioCards> Cards(Scenarios.size());
+	std::vector<int> LaunchDayArr(Scenarios.size());
+	//Nothing is shared between calls
+	CardInterner intern;
+	PresettingStore store;
+	//Scratch memory of each scenario
+	ScenarioArena arena;
+
+	store.Reset(Scenarios.size());
+
+	Deck.Cards.clear();
+	Deck.Text.clear();
+	Deck.Binary.clear();
+	Deck.Errors.clear();
+
+	for (size_t i = 0; i < Scenarios.size(); i++) LaunchDayArr[i] = Scenarios[i].LaunchDay;
+	std::string DayError;
+	if (CheckLaunchDays(LaunchDayArr, DayError) == false)
+	{
+		Deck.Errors.push_back("Deck " + DayError + "!");
+		return false;
+	}
+
+	for (size_t i = 0; i < Scenarios.size(); i++)
+	{
+		const ScenarioInput &input = Scenarios[i];
+		//Files are named in the messages, buffers by their position
+		std::string Name = input.FileName.empty() ? "Scenario " + std::to_string(i + 1) : "File " + input.FileName;
+		ArenaScope scope(arena);
+		ScenarioIndex in(arena.Resource());
+
+		if (input.FileName.empty()) in.LoadBuffer(input.Contents, stats);
+		else if ((input.FileName == StdStream ? in.LoadStream(stdin, stats) : in.Load(input.FileName, stats)) == false)
+		{
+			Deck.Errors.push_back(Name + " not found!");
+			continue;
+		}
+
+		store.Extract(i, in, Cards[i].Errors, stats);
+		for (size_t k = 0; k < Cards[i].Errors.size(); k++)
+		{
+			const ScenarioError &err = Cards[i].Errors[k];
+			Deck.Errors.push_back(Name + " line " + std::to_string(err.Line) + " column " + std::to_string(err.Column) + ": " + std::string(err.Key) + " is not a number!");
+		}
+	}
+	if (Deck.Errors.empty() == false) return false;
+
+	store.Convert(stats);
+	for (size_t i = 0; i < Scenarios.size(); i++)
+	{
+		store.Render(i, Scenarios[i].LaunchDay, Cards[i], &intern, stats);
+	}
+
+	size_t n = DeckSize(Cards.data(), Cards.size());
+	Deck.Cards.reserve(n);
+	Deck.Text.reserve(n * (80 + CardEnd.length()));
+
+	std::string Error;
+	bool ok = ForEachDeckCard(Year, LaunchDayArr, Cards.data(), Error, [&](const CardRecord &card)
+	{
+		Deck.Cards.push_back(card);
+		Deck.Text.append(card.Text, 80);
+		Deck.Text.append(CardEnd);
+	});
+	if (ok == false)
+	{
+		Deck.Errors.push_back("Deck not generated: " + Error + "!");
+		return false;
+	}
+
+	DeckJob job;
+	job.Year = Year;
+	job.LaunchDayArr = LaunchDayArr;
+	WriteBinaryDeck(job, Cards.data(), Deck.Binary, Error);
+	return true;
+}
+
+bool WriteFileAtomic(const std::string &FileName, const std::string &Data)
+{
+	//Written to a temporary file first, which then replaces the output. Readers never see a partial file.
+	std::string TempName = FileName + ".tmp";
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(TempName.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) return false;
+
+	DWORD written = 0;
+	bool ok = WriteFile(hFile, Data.data(), (DWORD)Data.size(), &written, NULL) && written == Data.size();
+	ok = FlushFileBuffers(hFile) && ok;
+	CloseHandle(hFile);
+
+	if (ok) ok = MoveFileExA(TempName.c_str(), FileName.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE;
+	if (ok == false) DeleteFileA(TempName.c_str());
+	return ok;
+#else
+	int fd = open(TempName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) return false;
+
+	const char *p = Data.data();
+	size_t left = Data.size();
+	bool ok = true;
+
+	while (left > 0)
+	{
+		ssize_t n = write(fd, p, left);
+		if (n < 0)
+		{
+			if (errno == EINTR) continue;
+			ok = false;
+			break;
+		}
+		p += n;
+		left -= (size_t)n;
+	}
+	if (ok) ok = fsync(fd) == 0;
+	if (close(fd) != 0) ok = false;
+
+	if (ok) ok = rename(TempName.c_str(), FileName.c_str()) == 0;
+	if (ok == false)
+	{
+		unlink(TempName.c_str());
+		return false;
+	}
+
+	//Make the rename itself durable
+	size_t pos = FileName.find_last_of('/');
+	std::string Dir = pos == std::string::npos ? "." : pos == 0 ? "/" : FileName.substr(0, pos);
+	int dirfd = open(Dir.c_str(), O_RDONLY);
+	if (dirfd >= 0)
+	{
+		fsync(dirfd);
+		close(dirfd);
+	}
+	return true;
+#endif
+}
+
+bool WriteStream(std::FILE *file, const std::string &Data)
+{
+#ifdef _WIN32
+	//The cards have their line ends already
+	_setmode(_fileno(file), _O_BINARY);
+#endif
+	return fwrite(Data.data(), 1, Data.size(), file) == Data.size() && fflush(file) == 0;
+}
+
+double StatsClock()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void RunStats::Add(const RunStats &other)
+{
+	Open += other.Open;
+	Scan += other.Scan;
+	Lookup += other.Lookup;
+	Convert += other.Convert;
+	Format += other.Format;
+	Write += other.Write;
+	Bytes += other.Bytes;
+	Lines += other.Lines;
+	Keys += other.Keys;
+	Found += other.Found;
+	Defaulted += other.Defaulted;
+	Malformed += other.Malformed;
+	CacheHits += other.CacheHits;
+	CacheMisses += other.CacheMisses;
+	Interned += other.Interned;
+	for (int s = 0; s < 3; s++) Cards[s] += other.Cards[s];
+	ArenaAllocs += other.ArenaAllocs;
+	Scenarios += other.Scenarios;
+	ScenariosFailed += other.ScenariosFailed;
+	Decks += other.Decks;
+	DecksFailed += other.DecksFailed;
+}
+
+std::string RunStats::ToJSON(double Wall, unsigned Threads) const
+{
+	std::ostringstream js;
+
+	js.precision(6);
+	js << std::fixed;
+	js << "{\n";
+	js << "  \"version\": 1,\n";
+	js << "  \"threads\": " << Threads << ",\n";
+	js << "  \"scanner\": \"" << GetLineScanner().Name << "\",\n";
+	js << "  \"wall_seconds\": " << Wall << ",\n";
+	js << "  \"phase_seconds\": { \"open\": " << Open << ", \"scan\": " << Scan << ", \"lookup\": " << Lookup << ", \"convert\": " << Convert << ", \"format\": " << Format << ", \"write\": " << Write << " },\n";
+	js << "  \"scenarios\": { \"total\": " << Scenarios << ", \"failed\": " << ScenariosFailed << " },\n";
+	js << "  \"decks\": { \"total\": " << Decks << ", \"failed\": " << DecksFailed << " },\n";
+	js << "  \"bytes_read\": " << Bytes << ",\n";
+	js << "  \"lines_scanned\": " << Lines << ",\n";
+	js << "  \"lvdc_keys\": " << Keys << ",\n";
+	js << "  \"lookups\": { \"found\": " << Found << ", \"defaulted\": " << Defaulted << ", \"malformed\": " << Malformed << " },\n";
+	js << "  \"cache\": { \"hits\": " << CacheHits << ", \"misses\": " << CacheMisses << " },\n";
+	js << "  \"interned_cards\": " << Interned << ",\n";
+	js << "  \"arena_heap_allocs\": " << ArenaAllocs << ",\n";
+	js << "  \"cards\": { \"section1\": " << Cards[0] << ", \"section2\": " << Cards[1] << ", \"section3\": " << Cards[2] << ", \"total\": " << Cards[0] + Cards[1] + Cards[2] << " }\n";
+	js << "}\n";
+	return js.str();
+}
+
+void LayoutKeys(std::vector<const FieldDesc *> &Keys)
+{
+	std::unordered_map<std::string_view, bool> seen;
+
+	for (int s = 0; s < 3; s++)
+	{
+		for (size_t k = 0; k < SectionSize[s]; k++)
+		{
+			for (int f = 0; f < 4; f++)
+			{
+				const FieldDesc &field = SectionLayout[s][k].Field[f];
+				if (field.Type == FieldType::Value && seen.emplace(field.Key.View(), true).second) Keys.push_back(&field);
+			}
+		}
+	}
+}
+
+
+bool ParseInt(const std::string &str, int &val)
+{
+	const char *last = str.data() + str.size();
+	std::from_chars_result res = std::from_chars(str.data(), last, val);
+	return res.ec == std::errc() && res.ptr == last;
+}
+
+//Reads the decks of one manifest. Prefix goes before the scenario file names.
+static bool ParseManifest(const std::string &FileName, std::istream &file, const std::string &Prefix, std::vector<DeckJob> &Jobs)
+{
+	std::string line, keyword, value;
+	size_t pos;
+	int LineNum = 0, day;
+	//First deck of this manifest
+	size_t first = Jobs.size();
+	//Decks of this manifest with a YEAR line, any year is valid
+	std::vector<char> HaveYear;
+
+	while (std::getline(file, line))
+	{
+		LineNum++;
+
+		//Strip comments and surrounding whitespace. A comment starts a line or follows whitespace, file names may contain '#'.
+		for (pos = line.find('#'); pos != std::string::npos; pos = line.find('#', pos + 1))
+		{
+			if (pos == 0 || line[pos - 1] == ' ' || line[pos - 1] == '\t')
+			{
+				line.erase(pos);
+				break;
+			}
+		}
+		pos = line.find_last_not_of(" \t\r");
+		if (pos == std::string::npos) continue;
+		line.erase(pos + 1);
+		pos = line.find_first_not_of(" \t");
+		line.erase(0, pos);
+
+		pos = line.find_first_of(" \t");
+		keyword = line.substr(0, pos);
+		value = pos == std::string::npos ? "" : line.substr(line.find_first_not_of(" \t", pos));
+
+		if (keyword == "DECK" && value.empty() == false)
+		{
+			Jobs.push_back(DeckJob());
+			Jobs.back().FileNameOut = value;
+			Jobs.back().Year = 0;
+			HaveYear.push_back(false);
+			continue;
+		}
+		//All other entries belong to the last deck
+		if (Jobs.size() > first)
+		{
+			if (keyword == "YEAR" && ParseInt(value, Jobs.back().Year))
+			{
+				HaveYear.back() = true;
+				continue;
+			}
+
+			if (keyword == "SCENARIO")
+			{
+				//Launch day, then the scenario file name which may contain spaces
+				pos = value.find_first_of(" \t");
+				if (pos != std::string::npos && ParseInt(value.substr(0, pos), day))
+				{
+					Jobs.back().LaunchDayArr.push_back(day);
+					Jobs.back().FileNameInArr.push_back(Prefix + value.substr(value.find_first_not_of(" \t", pos)));
+					continue;
+				}
+			}
+		}
+
+		std::cout << FileName << "(" << LineNum << "): Invalid line" << std::endl;
+		return false;
+	}
+
+	for (size_t i = first; i < Jobs.size(); i++)
+	{
+		std::string Error;
+
+		if (HaveYear[i - first] == false || Jobs[i].FileNameInArr.empty())
+		{
+			std::cout << FileName << ": Deck " << Jobs[i].FileNameOut << " needs a year and at least one scenario" << std::endl;
+			return false;
+		}
+		if (CheckLaunchDays(Jobs[i].LaunchDayArr, Error) == false)
+		{
+			std::cout << FileName << ": Deck " << Jobs[i].FileNameOut << " " << Error << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool CheckLaunchDays(const std::vector<int> &LaunchDayArr, std::string &Error)
+{
+	bool seen[367] = {};
+
+	if (LaunchDayArr.empty() || LaunchDayArr.size() > (size_t)MaxDeckDays)
+	{
+		Error = "has " + std::to_string(LaunchDayArr.size()) + " launch days, it can have 1 to " + std::to_string(MaxDeckDays);
+		return false;
+	}
+	for (size_t i = 0; i < LaunchDayArr.size(); i++)
+	{
+		int day = LaunchDayArr[i];
+
+		if (day < 1 || day > 366)
+		{
+			Error = "has launch day " + std::to_string(day) + ", a day of year is 1 to 366";
+			return false;
+		}
+		if (seen[day])
+		{
+			Error = "has launch day " + std::to_string(day) + " more than once";
+			return false;
+		}
+		seen[day] = true;
+	}
+	return true;
+}
+
+bool ReadManifest(const std::string &FileName, std::vector<DeckJob> &Jobs)
+{
+	ScenarioArchive ar;
+
+	if (ar.Open(FileName))
+	{
+		std::vector<std::pair<std::string, std::string>> Manifests;
+
+		if (ar.ExtractAll(ar.HasMembers() ? ".manifest" : "", Manifests) == false)
+		{
+			std::cout << "File " << FileName << " is damaged!" << std::endl;
+			return false;
+		}
+		if (Manifests.empty())
+		{
+			std::cout << "File " << FileName << " has no manifest!" << std::endl;
+			return false;
+		}
+		//The scenarios of a mission archive are in the archive, relative to the manifest
+		for (size_t i = 0; i < Manifests.size(); i++)
+		{
+			std::istringstream file(Manifests[i].second);
+			std::string Name = ar.HasMembers() ? FileName + "/" + Manifests[i].first : FileName;
+			std::string Prefix;
+
+			if (ar.HasMembers())
+			{
+				size_t pos = Name.find_last_of('/');
+				Prefix = Name.substr(0, pos + 1);
+			}
+			if (ParseManifest(Name, file, Prefix, Jobs) == false) return false;
+		}
+		return true;
+	}
+
+	std::ifstream file(FileName);
+	if (file.is_open() == false)
+	{
+		std::cout << "File " << FileName << " not found!" << std::endl;
+		return false;
+	}
+	return ParseManifest(FileName, file, "", Jobs);
+}
+
+void *ScenarioArena::CountingResource::do_allocate(size_t bytes, size_t align)
+{
+	Allocs++;
+	Bytes += bytes;
+	Used += bytes;
+	return std::pmr::new_delete_resource()->allocate(bytes, align);
+}
+
+void ScenarioArena::CountingResource::do_deallocate(void *p, size_t bytes, size_t align)
+{
+	std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+}
+
+ScenarioArena::ScenarioArena(size_t Initial) : Size(Initial)
+{
+	Buffer = Heap.allocate(Size, alignof(std::max_align_t));
+	Heap.Used = 0;
+	Pool.emplace(Buffer, Size, &Heap);
+}
+
+ScenarioArena::~ScenarioArena()
+{
+	Pool.reset();
+	Heap.deallocate(Buffer, Size, alignof(std::max_align_t));
+}
+
+void ScenarioArena::Reset()
+{
+	//Gives the overflow blocks back to the heap
+	Pool.reset();
+
+	//The next scenario fits in one buffer if it is like this one
+	if (Heap.Used > 0 && Size < MaxCapacity)
+	{
+		size_t Needed = std::min(Size + Heap.Used, MaxCapacity);
+		Heap.deallocate(Buffer, Size, alignof(std::max_align_t));
+		Size = (Needed + 4095) & ~(size_t)4095;
+		Buffer = Heap.allocate(Size, alignof(std::max_align_t));
+	}
+	Heap.Used = 0;
+	Pool.emplace(Buffer, Size, &Heap);
+}
+
+//Arena of the pool thread this runs on
+static thread_local ScenarioArena *CurrentArena = nullptr;
+
+ThreadPool::ThreadPool(unsigned Threads) : Func(nullptr), Count(0), Next(0), Pending(0), Generation(0), Quit(false)
+{
+	if (Threads == 0) Threads = std::thread::hardware_concurrency();
+	if (Threads == 0) Threads = 1;
+
+	for (unsigned i = 0; i < Threads; i++)
+	{
+		Arenas.emplace_back(new ScenarioArena());
+	}
+	//The calling thread does its share of the work, too
+	for (unsigned i = 1; i < Threads; i++)
+	{
+		Workers.emplace_back(&ThreadPool::Worker, this, (size_t)i);
+	}
+}
+
+ScenarioArena &ThreadPool::Arena()
+{
+	return CurrentArena ? *CurrentArena : *Arenas[0];
+}
+
+uint64_t ThreadPool::ArenaHeapAllocs() const
+{
+	uint64_t n = 0;
+	for (size_t i = 0; i < Arenas.size(); i++) n += Arenas[i]->HeapAllocs();
+	return n;
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Quit = true;
+	}
+	WakeUp.notify_all();
+	for (size_t i = 0; i < Workers.size(); i++)
+	{
+		Workers[i].join();
+	}
+}
+
+void ThreadPool::Run(size_t count, const std::function<void(size_t)> &func)
+{
+	//The caller works with the first arena during the loop
+	ScenarioArena *CallerArena = CurrentArena;
+	CurrentArena = Arenas[0].get();
+
+	if (Workers.empty() || count <= 1)
+	{
+		for (size_t i = 0; i < count; i++) func(i);
+		CurrentArena = CallerArena;
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Func = &func;
+		Count = count;
+		Next = 0;
+		Pending = (unsigned)Workers.size();
+		Generation++;
+	}
+	WakeUp.notify_all();
+
+	RunItems();
+
+	//Every worker has to see this loop before the next one can be set up
+	std::unique_lock<std::mutex> lock(Mutex);
+	Done.wait(lock, [this] { return Pending == 0; });
+	Func = nullptr;
+	CurrentArena = CallerArena;
+}
+
+void ThreadPool::Worker(size_t Index)
+{
+	uint64_t seen = 0;
+	std::unique_lock<std::mutex> lock(Mutex);
+
+	CurrentArena = Arenas[Index].get();
+
+	while (true)
+	{
+		WakeUp.wait(lock, [&] { return Quit || Generation != seen; });
+		if (Quit) return;
+		seen = Generation;
+
+		lock.unlock();
+		RunItems();
+		lock.lock();
+
+		if (--Pending == 0) Done.notify_one();
+	}
+}
+
+void ThreadPool::RunItems()
+{
+	size_t i;
+	while ((i = Next.fetch_add(1)) < Count)
+	{
+		(*Func)(i);
+	}
+}
+
+#ifdef SCENARIO_URING
+//Submission and completion rings of an io_uring
+class IoRing
+{
+public:
+	IoRing() : fd(-1), SqPtr(MAP_FAILED), CqPtr(MAP_FAILED), SqeMem(MAP_FAILED), SqSize(0), CqSize(0), SqeSize(0), Queued(0) {}
+	IoRing(const IoRing &) = delete;
+	IoRing &operator=(const IoRing &) = delete;
+
+	~IoRing()
+	{
+		if (SqeMem != MAP_FAILED) munmap(SqeMem, SqeSize);
+		if (CqPtr != MAP_FAILED && CqPtr != SqPtr) munmap(CqPtr, CqSize);
+		if (SqPtr != MAP_FAILED) munmap(SqPtr, SqSize);
+		if (fd >= 0) close(fd);
+	}
+
+	//Returns false if the kernel has no io_uring or doesn't allow it
+	bool Init(unsigned Entries)
+	{
+		io_uring_params p;
+		memset(&p, 0, sizeof(p));
+
+		fd = (int)syscall(__NR_io_uring_setup, Entries, &p);
+		if (fd < 0) return false;
+
+		SqSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+		CqSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+		//Both rings in one mapping
+		bool Single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (Single) SqSize = CqSize = SqSize > CqSize ? SqSize : CqSize;
+
+		SqPtr = mmap(nullptr, SqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+		if (SqPtr == MAP_FAILED) return false;
+		CqPtr = Single ? SqPtr : mmap(nullptr, CqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if (CqPtr == MAP_FAILED) return false;
+		SqeSize = p.sq_entries * sizeof(io_uring_sqe);
+		SqeMem = mmap(nullptr, SqeSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+		if (SqeMem == MAP_FAILED) return false;
+
+		char *sq = (char *)SqPtr, *cq = (char *)CqPtr;
+		SqHead = (unsigned *)(sq + p.sq_off.head);
+		SqTail = (unsigned *)(sq + p.sq_off.tail);
+		SqMask = *(unsigned *)(sq + p.sq_off.ring_mask);
+		SqArray = (unsigned *)(sq + p.sq_off.array);
+		SqEntries = p.sq_entries;
+		CqHead = (unsigned *)(cq + p.cq_off.head);
+		CqTail = (unsigned *)(cq + p.cq_off.tail);
+		CqMask = *(unsigned *)(cq + p.cq_off.ring_mask);
+		Cqes = (io_uring_cqe *)(cq + p.cq_off.cqes);
+		Sqes = (io_uring_sqe *)SqeMem;
+		return true;
+	}
+
+	//Free submission entry, cleared. nullptr if the ring is full.
+	io_uring_sqe *GetSqe()
+	{
+		unsigned tail = *SqTail + Queued;
+		if (tail - __atomic_load_n(SqHead, __ATOMIC_ACQUIRE) >= SqEntries) return nullptr;
+
+		io_uring_sqe *sqe = &Sqes[tail & SqMask];
+		memset(sqe, 0, sizeof(*sqe));
+		SqArray[tail & SqMask] = tail & SqMask;
+		Queued++;
+		return sqe;
+	}
+
+	//Submits the new entries, and waits for a completion if Wait is set. Returns false on an error of the ring.
+	bool Submit(bool Wait)
+	{
+		__atomic_store_n(SqTail, *SqTail + Queued, __ATOMIC_RELEASE);
+		Queued = 0;
+
+		while (true)
+		{
+			//Entries the kernel hasn't taken yet, also those left over from an earlier call
+			unsigned Count = *SqTail - __atomic_load_n(SqHead, __ATOMIC_ACQUIRE);
+			long n = syscall(__NR_io_uring_enter, fd, Count, Wait ? 1 : 0, Wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+			if (n >= 0) return true;
+			if (errno == EINTR) continue;
+			//Out of memory for now or the completion ring is full, the next call takes the rest after the completions are reaped
+			return errno == EAGAIN || errno == EBUSY;
+		}
+	}
+
+	//Turns the entries the kernel hasn't taken yet into no-ops with user_data Tag, e.g. after Submit failed, so that
+	//they never start. Returns their old user_data.
+	std::vector<uint64_t> Withdraw(uint64_t Tag)
+	{
+		std::vector<uint64_t> Data;
+		unsigned tail = *SqTail + Queued;
+
+		for (unsigned i = __atomic_load_n(SqHead, __ATOMIC_ACQUIRE); i != tail; i++)
+		{
+			io_uring_sqe *sqe = &Sqes[SqArray[i & SqMask]];
+			Data.push_back(sqe->user_data);
+			memset(sqe, 0, sizeof(*sqe));
+			sqe->opcode = IORING_OP_NOP;
+			sqe->user_data = Tag;
+		}
+		return Data;
+	}
+
+	//Oldest completion, or nullptr. Pop it when done with it.
+	io_uring_cqe *Peek()
+	{
+		unsigned head = *CqHead;
+		if (head == __atomic_load_n(CqTail, __ATOMIC_ACQUIRE)) return nullptr;
+		return &Cqes[head & CqMask];
+	}
+
+	void Pop()
+	{
+		__atomic_store_n(CqHead, *CqHead + 1, __ATOMIC_RELEASE);
+	}
+
+protected:
+	int fd;
+	void *SqPtr, *CqPtr, *SqeMem;
+	size_t SqSize, CqSize, SqeSize;
+	unsigned *SqHead, *SqTail, *SqArray, *CqHead, *CqTail;
+	unsigned SqMask, CqMask, SqEntries;
+	//Entries filled in since the last submit
+	unsigned Queued;
+	io_uring_sqe *Sqes;
+	io_uring_cqe *Cqes;
+};
+#endif
+
+const char *ScenarioReader::Backend()
+{
+#ifdef SCENARIO_URING
+	static const bool Uring = []
+	{
+		IoRing ring;
+		return ring.Init(4);
+	}();
+	if (Uring) return "io_uring";
+#endif
+	return "threads";
+}
+
+void ScenarioReader::Read(const std::vector<std::string> &Files, ThreadPool &pool, const std::function<void(size_t, const std::string *)> &Parse)
+{
+#ifdef SCENARIO_URING
+	//File read ahead, or nullptr when Parse has to load it
+	struct Item
+	{
+		size_t File;
+		std::string *Data;
+	};
+	//File being opened or read
+	struct Slot
+	{
+		size_t File;
+		int fd;
+		size_t Done;
+		std::string Data;
+	};
+
+	std::vector<Slot> Slots(Depth);
+	//Finished buffers, one per file, so that Parse gets a stable pointer
+	std::vector<std::string> Buffers(Files.size());
+	//Buffers Parse is done with, for the next files
+	std::vector<std::string> Spare;
+	IoRing ring;
+
+	if (Files.size() > 1 && ring.Init(Depth * 2))
+	{
+		std::deque<Item> Ready;
+		std::mutex Mutex;
+		std::condition_variable Changed;
+		//Items handed out to Parse and not yet done
+		size_t Parsing = 0;
+
+		Spare.reserve(Depth);
+
+		auto Push = [&](size_t File, std::string *Data)
+		{
+			{
+				std::lock_guard<std::mutex> lock(Mutex);
+				Ready.push_back({ File, Data });
+			}
+			Changed.notify_all();
+		};
+
+		std::thread io([&]
+		{
+			std::vector<unsigned> Free;
+			size_t Next = 0, Active = 0;
+			//user_data of entries that belong to no slot
+			const unsigned NoSlot = Depth;
+
+			for (unsigned i = 0; i < Depth; i++) Free.push_back(Depth - 1 - i);
+
+			//Hands a slot's file to the parser, or to Load if Data is nullptr
+			auto Finish = [&](unsigned s, bool Read)
+			{
+				Slot &slot = Slots[s];
+				if (slot.fd >= 0) close(slot.fd);
+				slot.fd = -1;
+				if (Read)
+				{
+					slot.Data.resize(slot.Done);
+					Buffers[slot.File].swap(slot.Data);
+				}
+				else if (slot.Data.empty() == false)
+				{
+					std::lock_guard<std::mutex> lock(Mutex);
+					Spare.push_back(std::move(slot.Data));
+					slot.Data.clear();
+				}
+				Push(slot.File, Read ? &Buffers[slot.File] : nullptr);
+				Free.push_back(s);
+				Active--;
+			};
+
+			//Reads the rest of a file, at most 1 GB at a time
+			auto QueueRead = [&](unsigned s)
+			{
+				Slot &slot = Slots[s];
+				size_t Len = slot.Data.size() - slot.Done;
+				io_uring_sqe *sqe = ring.GetSqe();
+
+				//The ring has two entries per slot, so it isn't full. If it is anyway, Parse loads the file.
+				if (sqe == nullptr)
+				{
+					Finish(s, false);
+					return;
+				}
+				sqe->opcode = IORING_OP_READ;
+				sqe->fd = slot.fd;
+				sqe->off = slot.Done;
+				sqe->addr = (uint64_t)(uintptr_t)(&slot.Data[0] + slot.Done);
+				sqe->len = (unsigned)(Len < (1U << 30) ? Len : (1U << 30));
+				sqe->user_data = s;
+			};
+
+			while (Next < Files.size() || Active > 0)
+			{
+				//Buffers waiting for the parser count against the depth, so memory stays bounded
+				size_t Waiting;
+				{
+					std::unique_lock<std::mutex> lock(Mutex);
+					if (Active == 0) Changed.wait(lock, [&] { return Ready.size() + Parsing < Depth; });
+					Waiting = Ready.size() + Parsing;
+				}
+
+				while (Next < Files.size() && Free.empty() == false && Active + Waiting < Depth)
+				{
+					size_t File = Next++;
+					std::string Archive, Member;
+
+					//Stdin and archive members go to Load
+					if (Files[File] == StdStream || ScenarioArchive::SplitPath(Files[File], Archive, Member))
+					{
+						Push(File, nullptr);
+						continue;
+					}
+
+					io_uring_sqe *sqe = ring.GetSqe();
+					if (sqe == nullptr)
+					{
+						Push(File, nullptr);
+						continue;
+					}
+
+					unsigned s = Free.back();
+					Free.pop_back();
+					Slots[s].File = File;
+					Slots[s].fd = -1;
+					Slots[s].Done = 0;
+					Active++;
+
+					sqe->opcode = IORING_OP_OPENAT;
+					sqe->fd = AT_FDCWD;
+					sqe->addr = (uint64_t)(uintptr_t)Files[File].c_str();
+					sqe->open_flags = O_RDONLY | O_CLOEXEC;
+					sqe->user_data = s;
+				}
+				if (Active == 0) continue;
+
+				io_uring_cqe *cqe;
+				if (ring.Submit(true) == false)
+				{
+					//Everything not read yet is loaded by Parse, once nothing is in flight any more
+					std::vector<char> Busy(Depth, 1);
+					for (unsigned s : Free) Busy[s] = 0;
+					size_t InFlight = Active;
+					bool Drained = true;
+
+					//Entries the kernel didn't take never start, the others are canceled and reaped
+					for (uint64_t Data : ring.Withdraw(NoSlot))
+					{
+						if (Data >= Depth) continue;
+						Busy[Data] = 0;
+						InFlight--;
+					}
+					for (unsigned s = 0; s < Depth; s++)
+					{
+						if (Busy[s] == 0) continue;
+						io_uring_sqe *sqe = ring.GetSqe();
+						//Without an entry the request is just waited for
+						if (sqe == nullptr) continue;
+						sqe->opcode = IORING_OP_ASYNC_CANCEL;
+						sqe->addr = s;
+						sqe->user_data = NoSlot;
+					}
+					while (InFlight > 0)
+					{
+						if (ring.Submit(true) == false)
+						{
+							Drained = false;
+							break;
+						}
+						while ((cqe = ring.Peek()) != nullptr)
+						{
+							unsigned s = (unsigned)cqe->user_data;
+							int res = cqe->res;
+							ring.Pop();
+							if (s == NoSlot || Busy[s] == 0) continue;
+							//An open that finished before it was canceled
+							if (Slots[s].fd < 0 && res >= 0) close(res);
+							Busy[s] = 0;
+							InFlight--;
+						}
+					}
+
+					for (unsigned s = 0; s < Depth; s++)
+					{
+						if (std::find(Free.begin(), Free.end(), s) != Free.end()) continue;
+						if (Slots[s].fd >= 0) close(Slots[s].fd);
+						Push(Slots[s].File, nullptr);
+					}
+					while (Next < Files.size()) Push(Next++, nullptr);
+					//The kernel may still write into the buffers in flight, so they are never freed
+					if (Drained == false) new std::vector<Slot>(std::move(Slots));
+					break;
+				}
+
+				while ((cqe = ring.Peek()) != nullptr)
+				{
+					unsigned s = (unsigned)cqe->user_data;
+					int res = cqe->res;
+					Slot &slot = Slots[s];
+					ring.Pop();
+
+					if (slot.fd < 0)
+					{
+						//Opened, the size gives the buffer
+						struct stat st;
+						if (res < 0)
+						{
+							Finish(s, false);
+							continue;
+						}
+						slot.fd = res;
+						if (fstat(slot.fd, &st) != 0 || S_ISREG(st.st_mode) == false)
+						{
+							Finish(s, false);
+							continue;
+						}
+						{
+							std::lock_guard<std::mutex> lock(Mutex);
+							if (Spare.empty() == false)
+							{
+								slot.Data.swap(Spare.back());
+								Spare.pop_back();
+							}
+						}
+						slot.Data.resize((size_t)st.st_size);
+						if (slot.Data.empty())
+						{
+							Finish(s, true);
+							continue;
+						}
+						QueueRead(s);
+						continue;
+					}
+
+					if (res == -EINTR || res == -EAGAIN)
+					{
+						QueueRead(s);
+						continue;
+					}
+					if (res < 0)
+					{
+						Finish(s, false);
+						continue;
+					}
+					slot.Done += (size_t)res;
+					//A file that got shorter ends early
+					if (res == 0 || slot.Done == slot.Data.size()) Finish(s, true);
+					else QueueRead(s);
+				}
+			}
+		});
+
+		pool.Run(Files.size(), [&](size_t)
+		{
+			Item item;
+			{
+				std::unique_lock<std::mutex> lock(Mutex);
+				Changed.wait(lock, [&] { return Ready.empty() == false; });
+				item = Ready.front();
+				Ready.pop_front();
+				Parsing++;
+			}
+
+			Parse(item.File, item.Data);
+
+			{
+				std::lock_guard<std::mutex> lock(Mutex);
+				//The buffer keeps its memory for another file
+				if (item.Data) Spare.push_back(std::move(*item.Data));
+				Parsing--;
+			}
+			Changed.notify_all();
+		});
+		io.join();
+		return;
+	}
+#endif
+	pool.Run(Files.size(), [&](size_t i) { Parse(i, nullptr); });
+}
+
+MappedFile::MappedFile() : Ptr(nullptr), Size(0)
+{
+#ifdef _WIN32
+	hMapping = NULL;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::string &FileName)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(FileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER FileSize;
+	if (GetFileSizeEx(hFile, &FileSize) == FALSE)
+	{
+		CloseHandle(hFile);
+		return false;
+	}
+	//Empty files can't be mapped
+	if (FileSize.QuadPart > 0)
+	{
+		hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (hMapping != NULL)
+		{
+			Ptr = (const char *)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+		}
+		if (Ptr == nullptr)
+		{
+			CloseHandle(hFile);
+			Close();
+			return false;
+		}
+		Size = (size_t)FileSize.QuadPart;
+	}
+	CloseHandle(hFile);
+#else
+	int fd = open(FileName.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		close(fd);
+		return false;
+	}
+	//Empty files can't be mapped
+	if (st.st_size > 0)
+	{
+		void *p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED)
+		{
+			close(fd);
+			return false;
+		}
+		madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+		Ptr = (const char *)p;
+		Size = (size_t)st.st_size;
+	}
+	close(fd);
+#endif
+	return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (Ptr) UnmapViewOfFile(Ptr);
+	if (hMapping) CloseHandle(hMapping);
+	hMapping = NULL;
+#else
+	if (Ptr) munmap((void *)Ptr, Size);
+#endif
+	Ptr = nullptr;
+	Size = 0;
+}
+
+//Decompresses a gzip file piece by piece, for tar archives that are read front to back
+class GzipReader
+{
+public:
+	GzipReader(std::string_view In);
+	~GzipReader();
+	GzipReader(const GzipReader &) = delete;
+	GzipReader &operator=(const GzipReader &) = delete;
+
+	//Returns the number of bytes read, less than len only at the end of the file or on an error
+	size_t Read(char *dest, size_t len);
+	//Skips len bytes, returns false if the file ends before
+	bool Skip(size_t len);
+	bool Failed() const { return Status != Z_OK && Status != Z_STREAM_END; }
+protected:
+	z_stream Stream;
+	//Input that doesn't fit into avail_in yet
+	const char *Next;
+	size_t Left;
+	int Status;
+};
+
+GzipReader::GzipReader(std::string_view In) : Next(In.data()), Left(In.size())
+{
+	memset(&Stream, 0, sizeof(Stream));
+	//32 + 15: gzip header, largest window
+	Status = inflateInit2(&Stream, 32 + 15);
+}
+
+GzipReader::~GzipReader()
+{
+	inflateEnd(&Stream);
+}
+
+size_t GzipReader::Read(char *dest, size_t len)
+{
+	size_t done = 0;
+
+	while (done < len && Status == Z_OK)
+	{
+		if (Stream.avail_in == 0 && Left > 0)
+		{
+			Stream.next_in = (Bytef *)Next;
+			Stream.avail_in = (uInt)std::min(Left, (size_t)1 << 30);
+			Next += Stream.avail_in;
+			Left -= Stream.avail_in;
+		}
+		Stream.next_out = (Bytef *)dest + done;
+		Stream.avail_out = (uInt)std::min(len - done, (size_t)1 << 30);
+
+		int ret = inflate(&Stream, Z_NO_FLUSH);
+		done = (char *)Stream.next_out - dest;
+
+		if (ret == Z_STREAM_END)
+		{
+			//gzip files can have several members, which are concatenated
+			if (Stream.avail_in == 0 && Left == 0) Status = Z_STREAM_END;
+			else Status = inflateReset(&Stream);
+		}
+		//No progress possible, the file is truncated
+		else if (ret == Z_BUF_ERROR && Stream.avail_in == 0 && Left == 0) Status = Z_DATA_ERROR;
+		else if (ret != Z_OK && ret != Z_BUF_ERROR) Status = ret;
+	}
+	return done;
+}
+
+bool GzipReader::Skip(size_t len)
+{
+	char buf[16384];
+
+	while (len > 0)
+	{
+		size_t n = std::min(len, sizeof(buf));
+		if (Read(buf, n) != n) return false;
+		len -= n;
+	}
+	return true;
+}
+
+bool ScenarioArchive::IsGzip(std::string_view Data)
+{
+	return Data.size() >= 2 && (unsigned char)Data[0] == 0x1f && (unsigned char)Data[1] == 0x8b;
+}
+
+bool ScenarioArchive::IsZip(std::string_view Data)
+{
+	//Local file header, or the end record of an empty archive
+	return Data.size() >= 4 && Data[0] == 'P' && Data[1] == 'K' && ((Data[2] == 3 && Data[3] == 4) || (Data[2] == 5 && Data[3] == 6));
+}
+
+//Decompresses into a std::string or a std::pmr::string
+template<class S>
+static bool GunzipTo(std::string_view In, S &Out)
+{
+	GzipReader gz(In);
+	size_t len = 0, n;
+
+	//The last 4 bytes are the size of the last member, modulo 2^32
+	Out.clear();
+	if (In.size() >= 18)
+	{
+		const unsigned char *p = (const unsigned char *)In.data() + In.size() - 4;
+		size_t size = (size_t)p[0] | (size_t)p[1] << 8 | (size_t)p[2] << 16 | (size_t)p[3] << 24;
+		//Deflate can't compress more than about 1:1032, anything above is a damaged file
+		Out.reserve(std::min(size, In.size() * 1032));
+	}
+
+	do
+	{
+		Out.resize(len + std::max((size_t)1 << 16, len / 2));
+		n = gz.Read(&Out[len], Out.size() - len);
+		len += n;
+	} while (len == Out.size());
+	Out.resize(len);
+	return gz.Failed() == false;
+}
+
+bool ScenarioArchive::Gunzip(std::string_view In, std::string &Out)
+{
+	return GunzipTo(In, Out);
+}
+
+bool ScenarioArchive::Gunzip(std::string_view In, std::pmr::string &Out)
+{
+	return GunzipTo(In, Out);
+}
+
+bool ScenarioArchive::SplitPath(const std::string &Path, std::string &Archive, std::string &Member)
+{
+	static const char *const Ext[] = { ".zip", ".tar.gz", ".tgz" };
+	std::string lower = Path;
+
+	for (size_t i = 0; i < lower.size(); i++) lower[i] = (char)tolower((unsigned char)lower[i]);
+
+	for (size_t pos = lower.find_first_of("/\\"); pos != std::string::npos; pos = lower.find_first_of("/\\", pos + 1))
+	{
+		for (const char *ext : Ext)
+		{
+			size_t len = strlen(ext);
+			if (pos >= len && lower.compare(pos - len, len, ext) == 0)
+			{
+				Archive = Path.substr(0, pos);
+				Member = Path.substr(pos + 1);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool ScenarioArchive::Open(const std::string &FileName)
+{
+	if (Map.Open(FileName) == false) return false;
+
+	std::string_view Data = Map.Data();
+
+	if (IsZip(Data))
+	{
+		Kind = ArchiveKind::Zip;
+		return true;
+	}
+	if (IsGzip(Data) == false) return false;
+
+	//A tar archive has "ustar" at offset 257 of the first header
+	GzipReader gz(Data);
+	char header[512];
+	Kind = gz.Read(header, 512) == 512 && memcmp(header + 257, "ustar", 5) == 0 ? ArchiveKind::Tar : ArchiveKind::Gzip;
+	return true;
+}
+
+template<class S>
+bool ScenarioArchive::ExtractTo(std::string_view Name, S &Data)
+{
+	bool found = false;
+
+	bool ok = ReadMembers([&](std::string_view member) { return member == Name; },
+		[&](std::string_view, S &)
+	{
+		found = true;
+		return false;
+	}, Data);
+	if (ok == false || found == false) Data.clear();
+	return ok && found;
+}
+
+bool ScenarioArchive::Extract(std::string_view Name, std::string &Data)
+{
+	return ExtractTo(Name, Data);
+}
+
+bool ScenarioArchive::Extract(std::string_view Name, std::pmr::string &Data)
+{
+	return ExtractTo(Name, Data);
+}
+
+bool ScenarioArchive::ExtractAll(std::string_view Suffix, std::vector<std::pair<std::string, std::string>> &Members)
+{
+	std::string contents;
+
+	return ReadMembers([&](std::string_view member) { return member.size() >= Suffix.size() && member.substr(member.size() - Suffix.size()) == Suffix; },
+		[&](std::string_view member, std::string &data)
+	{
+		Members.emplace_back(std::string(member), std::move(data));
+		return true;
+	}, contents);
+}
+
+template<class S, class F>
+bool ScenarioArchive::ReadMembers(const std::function<bool(std::string_view)> &Wanted, F Found, S &Contents)
+{
+	switch (Kind)
+	{
+	case ArchiveKind::Gzip:
+		if (Wanted("") == false) return true;
+		if (GunzipTo(Map.Data(), Contents) == false) return false;
+		Found("", Contents);
+		return true;
+	case ArchiveKind::Tar:
+		return ReadTar(Wanted, Found, Contents);
+	case ArchiveKind::Zip:
+		return ReadZip(Wanted, Found, Contents);
+	}
+	return false;
+}
+
+//Octal number field of a tar header
+static bool TarNumber(const char *p, size_t len, size_t &val)
+{
+	val = 0;
+	while (len > 0 && (*p == ' ' || *p == '\0'))
+	{
+		p++;
+		len--;
+	}
+	for (; len > 0 && *p >= '0' && *p <= '7'; p++, len--) val = val * 8 + (*p - '0');
+	return len == 0 || *p == ' ' || *p == '\0';
+}
+
+template<class S, class F>
+bool ScenarioArchive::ReadTar(const std::function<bool(std::string_view)> &Wanted, F Found, S &contents)
+{
+	GzipReader gz(Map.Data());
+	char header[512];
+	std::string name, LongName;
+	size_t size;
+
+	while (gz.Read(header, 512) == 512)
+	{
+		//Two zero blocks end the archive
+		if (header[0] == '\0') return true;
+		//Deflate can't compress more than about 1:1032
+		if (TarNumber(header + 124, 12, size) == false || size / 1032 > Map.Data().size()) return false;
+
+		char type = header[156];
+		size_t padded = (size + 511) & ~(size_t)511;
+
+		//GNU long name of the next member
+		if (type == 'L')
+		{
+			LongName.resize(padded);
+			if (gz.Read(&LongName[0], padded) != padded) return false;
+			LongName.resize(strnlen(LongName.data(), size));
+			continue;
+		}
+		//pax header of the next member, records of "<length> <key>=<value>\n"
+		if (type == 'x')
+		{
+			contents.resize(padded);
+			if (gz.Read(&contents[0], padded) != padded) return false;
+			for (size_t rec = 0, len = 0; rec < size; rec += len)
+			{
+				const char *p = contents.data() + rec;
+				std::from_chars_result res = std::from_chars(p, contents.data() + size, len);
+				if (res.ec != std::errc() || *res.ptr != ' ' || len == 0 || rec + len > size) return false;
+
+				std::string_view record(res.ptr + 1, p + len - 1 - (res.ptr + 1));
+				if (record.substr(0, 5) == "path=") LongName = std::string(record.substr(5));
+			}
+			continue;
+		}
+
+		if (LongName.empty())
+		{
+			//ustar prefix, then the name
+			name.clear();
+			if (header[345] != '\0') name.append(header + 345, strnlen(header + 345, 155)).push_back('/');
+			name.append(header, strnlen(header, 100));
+		}
+		else name.swap(LongName);
+		LongName.clear();
+
+		//Archives made from "." have all names start with ./
+		std::string_view member = name;
+		while (member.substr(0, 2) == "./") member.remove_prefix(2);
+
+		//Regular files only
+		if ((type == '0' || type == '\0') && Wanted(member))
+		{
+			contents.resize(size);
+			if (gz.Read(&contents[0], size) != size || gz.Skip(padded - size) == false) return false;
+			if (Found(member, contents) == false) return true;
+		}
+		else if (gz.Skip(padded) == false) return false;
+	}
+	return gz.Failed() == false;
+}
+
+static inline uint32_t ReadLE16(const char *p)
+{
+	const unsigned char *u = (const unsigned char *)p;
+	return (uint32_t)u[0] | (uint32_t)u[1] << 8;
+}
+
+static inline uint32_t ReadLE32(const char *p)
+{
+	const unsigned char *u = (const unsigned char *)p;
+	return (uint32_t)u[0] | (uint32_t)u[1] << 8 | (uint32_t)u[2] << 16 | (uint32_t)u[3] << 24;
+}
+
+template<class S, class F>
+bool ScenarioArchive::ReadZip(const std::function<bool(std::string_view)> &Wanted, F Found, S &contents)
+{
+	std::string_view Data = Map.Data();
+	const char *begin = Data.data();
+
+	//End of central directory record, before a comment of up to 64 KiB
+	if (Data.size() < 22) return false;
+	size_t eocd = Data.size() - 22;
+	size_t stop = eocd > 65535 ? eocd - 65535 : 0;
+	while (memcmp(begin + eocd, "PK\5\6", 4) != 0)
+	{
+		if (eocd == stop) return false;
+		eocd--;
+	}
+
+	size_t entries = ReadLE16(begin + eocd + 10);
+	size_t pos = ReadLE32(begin + eocd + 16);
+
+	for (size_t i = 0; i < entries; i++)
+	{
+		//Central directory header
+		if (pos + 46 > Data.size() || memcmp(begin + pos, "PK\1\2", 4) != 0) return false;
+
+		const char *cd = begin + pos;
+		uint32_t method = ReadLE16(cd + 10), crc = ReadLE32(cd + 16);
+		size_t csize = ReadLE32(cd + 20), usize = ReadLE32(cd + 24);
+		size_t NameLen = ReadLE16(cd + 28), ExtraLen = ReadLE16(cd + 30), CommentLen = ReadLE16(cd + 32);
+		size_t local = ReadLE32(cd + 42);
+
+		pos += 46 + NameLen + ExtraLen + CommentLen;
+		if (pos > Data.size()) return false;
+
+		std::string_view member(cd + 46, NameLen);
+		//Directories
+		if (member.empty() || member.back() == '/' || Wanted(member) == false) continue;
+
+		//Sizes of 0xFFFFFFFF are in a zip64 record, which isn't supported
+		if (csize == 0xFFFFFFFF || usize == 0xFFFFFFFF || local == 0xFFFFFFFF) return false;
+		//Local header, with its own name and extra field lengths
+		if (local + 30 > Data.size() || memcmp(begin + local, "PK\3\4", 4) != 0) return false;
+		size_t start = local + 30 + ReadLE16(begin + local + 26) + ReadLE16(begin + local + 28);
+		if (start > Data.size() || csize > Data.size() - start || usize / 1032 > csize) return false;
+
+		contents.resize(usize);
+		if (method == 0)
+		{
+			if (csize != usize) return false;
+			memcpy(&contents[0], begin + start, usize);
+		}
+		else if (method == 8)
+		{
+			z_stream zs;
+			memset(&zs, 0, sizeof(zs));
+			//Raw deflate without header
+			if (inflateInit2(&zs, -15) != Z_OK) return false;
+			zs.next_in = (Bytef *)(begin + start);
+			zs.avail_in = (uInt)csize;
+			zs.next_out = (Bytef *)&contents[0];
+			zs.avail_out = (uInt)usize;
+			int ret = inflate(&zs, Z_FINISH);
+			size_t out = zs.total_out;
+			inflateEnd(&zs);
+			if (ret != Z_STREAM_END || out != usize) return false;
+		}
+		//Other compression methods
+		else return false;
+
+		if (crc32(0L, (const Bytef *)contents.data(), (uInt)usize) != crc) return false;
+		if (Found(member, contents) == false) return true;
+	}
+	return true;
+}
+
+static const char *FindKeyScalar(const char *p, const char *end)
+{
+	while (end - p >= 5)
+	{
+		p = (const char *)memchr(p, 'L', end - p - 4);
+		if (p == nullptr) break;
+		if (!memcmp(p, "LVDC_", 5)) return p;
+		p++;
+	}
+	return end;
+}
+
+static size_t CountLinesScalar(const char *p, const char *end)
+{
+	size_t n = 0;
+	while ((p = (const char *)memchr(p, '\n', end - p)) != nullptr)
+	{
+		n++;
+		p++;
+	}
+	return n;
+}
+
+#ifdef SCANNER_X86
+static inline unsigned LowestBit(unsigned mask)
+{
+#ifdef _MSC_VER
+	unsigned long bit;
+	_BitScanForward(&bit, mask);
+	return bit;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+//Both kernels compare the first and the last byte of "LVDC_" for a whole block at once
+//and only check the bytes in between for the candidates.
+static const char *FindKeySSE2(const char *p, const char *end)
+{
+	const __m128i first = _mm_set1_epi8('L');
+	const __m128i last = _mm_set1_epi8('_');
+
+	while (end - p >= 16 + 4)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i *)p);
+		__m128i b = _mm_loadu_si128((const __m128i *)(p + 4));
+		unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+		while (mask)
+		{
+			unsigned bit = LowestBit(mask);
+			if (!memcmp(p + bit + 1, "VDC", 3)) return p + bit;
+			mask &= mask - 1;
+		}
+		p += 16;
+	}
+	return FindKeyScalar(p, end);
+}
+
+//Newline matches are summed in 8 bit lanes, which are added up before they can overflow
+static size_t CountLinesSSE2(const char *p, const char *end)
+{
+	const __m128i nl = _mm_set1_epi8('\n');
+	size_t n = 0;
+
+	while (end - p >= 16)
+	{
+		__m128i sum = _mm_setzero_si128();
+		for (int i = 0; i < 255 && end - p >= 16; i++, p += 16)
+		{
+			sum = _mm_sub_epi8(sum, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), nl));
+		}
+		sum = _mm_sad_epu8(sum, _mm_setzero_si128());
+		n += (size_t)_mm_cvtsi128_si32(sum) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+	}
+	return n + CountLinesScalar(p, end);
+}
+
+#ifndef _MSC_VER
+__attribute__((target("avx2")))
+#endif
+static const char *FindKeyAVX2(const char *p, const char *end)
+{
+	const __m256i first = _mm256_set1_epi8('L');
+	const __m256i last = _mm256_set1_epi8('_');
+
+	while (end - p >= 32 + 4)
+	{
+		__m256i a = _mm256_loadu_si256((const __m256i *)p);
+		__m256i b = _mm256_loadu_si256((const __m256i *)(p + 4));
+		unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+		while (mask)
+		{
+			unsigned bit = LowestBit(mask);
+			if (!memcmp(p + bit + 1, "VDC", 3)) return p + bit;
+			mask &= mask - 1;
+		}
+		p += 32;
+	}
+	return FindKeySSE2(p, end);
+}
+
+#ifndef _MSC_VER
+__attribute__((target("avx2")))
+#endif
+static size_t CountLinesAVX2(const char *p, const char *end)
+{
+	const __m256i nl = _mm256_set1_epi8('\n');
+	size_t n = 0;
+
+	while (end - p >= 32)
+	{
+		__m256i sum = _mm256_setzero_si256();
+		for (int i = 0; i < 255 && end - p >= 32; i++, p += 32)
+		{
+			sum = _mm256_sub_epi8(sum, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)p), nl));
+		}
+		sum = _mm256_sad_epu8(sum, _mm256_setzero_si256());
+		n += (size_t)_mm256_extract_epi64(sum, 0) + (size_t)_mm256_extract_epi64(sum, 1) + (size_t)_mm256_extract_epi64(sum, 2) + (size_t)_mm256_extract_epi64(sum, 3);
+	}
+	return n + CountLinesSSE2(p, end);
+}
+
+static bool HasAVX2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+	__cpuid(info, 1);
+	//OSXSAVE and AVX, and the OS saves the YMM registers
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+	if ((_xgetbv(0) & 6) != 6) return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+//Passes over the columns of a PresettingStore for the unit conversions
+struct ConvertKernel
+{
+	//col[i] = col[i] op c, op is one of ConvStep
+	void (*Apply)(double *col, size_t n, char op, double c);
+	//col[i] = col[i] + c * ref[i]
+	void (*MulAdd)(double *col, const double *ref, size_t n, double c);
+	const char *Name;
+};
+
+static void ApplyScalar(double *col, size_t n, char op, double c)
+{
+	size_t i;
+
+	switch (op)
+	{
+	case '*':
+		for (i = 0; i < n; i++) col[i] = col[i] * c;
+		break;
+	case '/':
+		for (i = 0; i < n; i++) col[i] = col[i] / c;
+		break;
+	case '+':
+		for (i = 0; i < n; i++) col[i] = col[i] + c;
+		break;
+	}
+}
+
+static void MulAddScalar(double *col, const double *ref, size_t n, double c)
+{
+	for (size_t i = 0; i < n; i++) col[i] = col[i] + c * ref[i];
+}
+
+#ifdef SCANNER_X86
+static void ApplySSE2(double *col, size_t n, char op, double c)
+{
+	const __m128d v = _mm_set1_pd(c);
+	size_t i = 0;
+
+	switch (op)
+	{
+	case '*':
+		for (; i + 2 <= n; i += 2) _mm_storeu_pd(col + i, _mm_mul_pd(_mm_loadu_pd(col + i), v));
+		break;
+	case '/':
+		for (; i + 2 <= n; i += 2) _mm_storeu_pd(col + i, _mm_div_pd(_mm_loadu_pd(col + i), v));
+		break;
+	case '+':
+		for (; i + 2 <= n; i += 2) _mm_storeu_pd(col + i, _mm_add_pd(_mm_loadu_pd(col + i), v));
+		break;
+	}
+	ApplyScalar(col + i, n - i, op, c);
+}
+
+static void MulAddSSE2(double *col, const double *ref, size_t n, double c)
+{
+	const __m128d v = _mm_set1_pd(c);
+	size_t i = 0;
+
+	//No FMA, the product is rounded like in the scalar code
+	for (; i + 2 <= n; i += 2) _mm_storeu_pd(col + i, _mm_add_pd(_mm_loadu_pd(col + i), _mm_mul_pd(v, _mm_loadu_pd(ref + i))));
+	MulAddScalar(col + i, ref + i, n - i, c);
+}
+
+#ifndef _MSC_VER
+__attribute__((target("avx2")))
+#endif
+static void ApplyAVX2(double *col, size_t n, char op, double c)
+{
+	const __m256d v = _mm256_set1_pd(c);
+	size_t i = 0;
+
+	switch (op)
+	{
+	case '*':
+		for (; i + 4 <= n; i += 4) _mm256_storeu_pd(col + i, _mm256_mul_pd(_mm256_loadu_pd(col + i), v));
+		break;
+	case '/':
+		for (; i + 4 <= n; i += 4) _mm256_storeu_pd(col + i, _mm256_div_pd(_mm256_loadu_pd(col + i), v));
+		break;
+	case '+':
+		for (; i + 4 <= n; i += 4) _mm256_storeu_pd(col + i, _mm256_add_pd(_mm256_loadu_pd(col + i), v));
+		break;
+	}
+	ApplySSE2(col + i, n - i, op, c);
+}
+
+#ifndef _MSC_VER
+__attribute__((target("avx2")))
+#endif
+static void MulAddAVX2(double *col, const double *ref, size_t n, double c)
+{
+	const __m256d v = _mm256_set1_pd(c);
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) _mm256_storeu_pd(col + i, _mm256_add_pd(_mm256_loadu_pd(col + i), _mm256_mul_pd(v, _mm256_loadu_pd(ref + i))));
+	MulAddSSE2(col + i, ref + i, n - i, c);
+}
+#endif
+
+//Fastest conversion kernel the CPU supports, AVX2, SSE2 or scalar
+static const ConvertKernel &GetConvertKernel()
+{
+#ifdef SCANNER_X86
+	static const ConvertKernel SSE2 = { ApplySSE2, MulAddSSE2, "SSE2" };
+	static const ConvertKernel AVX2 = { ApplyAVX2, MulAddAVX2, "AVX2" };
+	static const ConvertKernel &Best = HasAVX2() ? AVX2 : SSE2;
+	return Best;
+#else
+	static const ConvertKernel Scalar = { ApplyScalar, MulAddScalar, "scalar" };
+	return Scalar;
+#endif
+}
+
+//Batched checks over the columns of a PresettingStore. Each returns true if any of the n rows fails, the rows are then
+//found with a scalar pass.
+struct CheckKernel
+{
+	//A value is infinite or NaN
+	bool (*AnyNonFinite)(const double *col, size_t n);
+	//A value is below lo or above hi, NaN is not. Infinite values that pass the fast check are reported by the finite
+	//rule only.
+	bool (*AnyOutside)(const double *col, size_t n, double lo, double hi);
+	//a[i] > b[i] for a row
+	bool (*AnyAbove)(const double *a, const double *b, size_t n);
+	const char *Name;
+};
+
+static bool AnyNonFiniteScalar(const double *col, size_t n)
+{
+	bool any = false;
+	//inf * 0 and NaN * 0 are NaN
+	for (size_t i = 0; i < n; i++) any |= !(col[i] * 0.0 == 0.0);
+	return any;
+}
+
+static bool AnyOutsideScalar(const double *col, size_t n, double lo, double hi)
+{
+	bool any = false;
+	for (size_t i = 0; i < n; i++) any |= (col[i] < lo) | (col[i] > hi);
+	return any;
+}
+
+static bool AnyAboveScalar(const double *a, const double *b, size_t n)
+{
+	bool any = false;
+	for (size_t i = 0; i < n; i++) any |= a[i] > b[i];
+	return any;
+}
+
+#ifdef SCANNER_X86
+static bool AnyNonFiniteSSE2(const double *col, size_t n)
+{
+	const __m128d zero = _mm_setzero_pd();
+	__m128d any = zero;
+	size_t i = 0;
+
+	for (; i + 2 <= n; i += 2) any = _mm_or_pd(any, _mm_cmpneq_pd(_mm_mul_pd(_mm_loadu_pd(col + i), zero), zero));
+	return _mm_movemask_pd(any) != 0 || AnyNonFiniteScalar(col + i, n - i);
+}
+
+static bool AnyOutsideSSE2(const double *col, size_t n, double lo, double hi)
+{
+	const __m128d vlo = _mm_set1_pd(lo), vhi = _mm_set1_pd(hi);
+	__m128d any = _mm_setzero_pd();
+	size_t i = 0;
+
+	for (; i + 2 <= n; i += 2)
+	{
+		__m128d x = _mm_loadu_pd(col + i);
+		any = _mm_or_pd(any, _mm_or_pd(_mm_cmplt_pd(x, vlo), _mm_cmpgt_pd(x, vhi)));
+	}
+	return _mm_movemask_pd(any) != 0 || AnyOutsideScalar(col + i, n - i, lo, hi);
+}
+
+static bool AnyAboveSSE2(const double *a, const double *b, size_t n)
+{
+	__m128d any = _mm_setzero_pd();
+	size_t i = 0;
+
+	for (; i + 2 <= n; i += 2) any = _mm_or_pd(any, _mm_cmpgt_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+	return _mm_movemask_pd(any) != 0 || AnyAboveScalar(a + i, b + i, n - i);
+}
+
+#ifndef _MSC_VER
+__attribute__((target("avx2")))
+#endif
+static bool AnyNonFiniteAVX2(const double *col, size_t n)
+{
+	const __m256d zero = _mm256_setzero_pd();
+	__m256d any = zero;
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) any = _mm256_or_pd(any, _mm256_cmp_pd(_mm256_mul_pd(_mm256_loadu_pd(col + i), zero), zero, _CMP_NEQ_UQ));
+	return _mm256_movemask_pd(any) != 0 || AnyNonFiniteSSE2(col + i, n - i);
+}
+
+#ifndef _MSC_VER
+__attribute__((target("avx2")))
+#endif
+static bool AnyOutsideAVX2(const double *col, size_t n, double lo, double hi)
+{
+	const __m256d vlo = _mm256_set1_pd(lo), vhi = _mm256_set1_pd(hi);
+	__m256d any = _mm256_setzero_pd();
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256d x = _mm256_loadu_pd(col + i);
+		any = _mm256_or_pd(any, _mm256_or_pd(_mm256_cmp_pd(x, vlo, _CMP_LT_OQ), _mm256_cmp_pd(x, vhi, _CMP_GT_OQ)));
+	}
+	return _mm256_movemask_pd(any) != 0 || AnyOutsideSSE2(col + i, n - i, lo, hi);
+}
+
+#ifndef _MSC_VER
+__attribute__((target("avx2")))
+#endif
+static bool AnyAboveAVX2(const double *a, const double *b, size_t n)
+{
+	__m256d any = _mm256_setzero_pd();
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) any = _mm256_or_pd(any, _mm256_cmp_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), _CMP_GT_OQ));
+	return _mm256_movemask_pd(any) != 0 || AnyAboveSSE2(a + i, b + i, n - i);
+}
+#endif
+
+//Fastest check kernel the CPU supports, AVX2, SSE2 or scalar
+static const CheckKernel &GetCheckKernel()
+{
+#ifdef SCANNER_X86
+	static const CheckKernel SSE2 = { AnyNonFiniteSSE2, AnyOutsideSSE2, AnyAboveSSE2, "SSE2" };
+	static const CheckKernel AVX2 = { AnyNonFiniteAVX2, AnyOutsideAVX2, AnyAboveAVX2, "AVX2" };
+	static const CheckKernel &Best = HasAVX2() ? AVX2 : SSE2;
+	return Best;
+#else
+	static const CheckKernel Scalar = { AnyNonFiniteScalar, AnyOutsideScalar, AnyAboveScalar, "scalar" };
+	return Scalar;
+#endif
+}
+
+const LineScanner &GetLineScanner()
+{
+#ifdef SCANNER_X86
+	static const LineScanner SSE2 = { FindKeySSE2, CountLinesSSE2, "SSE2" };
+	static const LineScanner AVX2 = { FindKeyAVX2, CountLinesAVX2, "AVX2" };
+	static const LineScanner &Best = HasAVX2() ? AVX2 : SSE2;
+	return Best;
+#else
+	static const LineScanner Scalar = { FindKeyScalar, CountLinesScalar, "scalar" };
+	return Scalar;
+#endif
+}
+
+constexpr uint64_t HashSeed = 14695981039346656037ULL;
+
+//64 bit FNV-1a, for the cache keys
+static uint64_t HashBytes(uint64_t h, const void *data, size_t len)
+{
+	const unsigned char *p = (const unsigned char *)data;
+	for (size_t i = 0; i < len; i++)
+	{
+		h ^= p[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+//Whitespace as skipped by the scanf %s conversion
+static inline bool IsBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+//Parses a presetting. Unlike %lf the whole token has to be a number, "1.5x" is malformed and not 1.5.
+static bool ParseValue(const char *first, const char *last, double &val)
+{
+	if (first != last && *first == '+')
+	{
+		first++;
+		if (first != last && *first == '-') return false;
+	}
+	std::from_chars_result res = std::from_chars(first, last, val);
+	return res.ec == std::errc() && res.ptr == last;
+}
+
+ScenarioIndex::ScenarioIndex(std::pmr::memory_resource *Memory) : Extracted(Memory), Kept(Memory), KeptLines(Memory), Values(Memory), Resolved(0), Hash(HashSeed)
+{
+}
+
+bool ScenarioIndex::Load(const std::string &FileName, RunStats *stats)
+{
+	double start = stats ? StatsClock() : 0.0;
+
+	Reset();
+
+	std::string Archive, Member;
+	ScenarioArchive ar;
+	if (ScenarioArchive::SplitPath(FileName, Archive, Member) && ar.Open(Archive))
+	{
+		//Member of a zip or tar archive
+		Map.Close();
+		if (ar.HasMembers() == false || ar.Extract(Member, Extracted) == false) return false;
+		Text = Extracted;
+	}
+	else
+	{
+		if (Map.Open(FileName) == false) return false;
+		Text = Map.Data();
+		if (ScenarioArchive::IsGzip(Text))
+		{
+			if (ScenarioArchive::Gunzip(Text, Kept) == false) return false;
+			Map.Close();
+			Text = Kept;
+		}
+	}
+
+	//Decompression counts as opening the file
+	double opened = stats ? StatsClock() : 0.0;
+
+	size_t scanned = Index(Text, 0);
+
+	if (stats)
+	{
+		stats->Open += opened - start;
+		stats->Scan += StatsClock() - opened;
+		//Lines are only counted for the report, up to where the scan stopped
+		stats->Bytes += scanned;
+		stats->Lines += GetLineScanner().CountLines(Text.data(), Text.data() + scanned) + (scanned == 0 || Text[scanned - 1] == '\n' ? 0 : 1);
+		stats->Keys += Resolved;
+	}
+	return true;
+}
+
+bool ScenarioIndex::LoadBuffer(std::string_view Contents, RunStats *stats)
+{
+	double start = stats ? StatsClock() : 0.0;
+
+	Reset();
+	Map.Close();
+
+	Text = Contents;
+	size_t scanned = Index(Text, 0);
+
+	if (stats)
+	{
+		stats->Scan += StatsClock() - start;
+		stats->Bytes += scanned;
+		stats->Lines += GetLineScanner().CountLines(Text.data(), Text.data() + scanned) + (scanned == 0 || Text[scanned - 1] == '\n' ? 0 : 1);
+		stats->Keys += Resolved;
+	}
+	return true;
+}
+
+bool ScenarioIndex::LoadRead(std::string_view Contents, RunStats *stats)
+{
+	double start = stats ? StatsClock() : 0.0;
+
+	Reset();
+	Map.Close();
+
+	Text = Contents;
+	if (ScenarioArchive::IsGzip(Text))
+	{
+		if (ScenarioArchive::Gunzip(Text, Kept) == false) return false;
+		Text = Kept;
+	}
+
+	double opened = stats ? StatsClock() : 0.0;
+
+	size_t scanned = Index(Text, 0);
+
+	if (stats)
+	{
+		stats->Open += opened - start;
+		stats->Scan += StatsClock() - opened;
+		stats->Bytes += scanned;
+		stats->Lines += GetLineScanner().CountLines(Text.data(), Text.data() + scanned) + (scanned == 0 || Text[scanned - 1] == '\n' ? 0 : 1);
+		stats->Keys += Resolved;
+	}
+	return true;
+}
+
+bool ScenarioIndex::LoadStream(std::FILE *file, RunStats *stats)
+{
+	double start = stats ? StatsClock() : 0.0;
+	uint64_t Bytes = 0;
+	//Last line of the stream has no line break
+	bool OpenLine = false;
+	const size_t ChunkSize = 1 << 16;
+	const LineScanner &scan = GetLineScanner();
+	//Unprocessed end of the last chunk, then the new chunk
+	std::pmr::string buf(Kept.get_allocator());
+	const char *begin, *end, *p, *line, *eol, *key, *counted;
+	size_t len, n, KeptSize;
+	unsigned LineNum = 1;
+	bool eof = false;
+
+	Reset();
+	Map.Close();
+
+#ifdef _WIN32
+	_setmode(_fileno(file), _O_BINARY);
+#endif
+
+	while (eof == false)
+	{
+		len = buf.size();
+		buf.resize(len + ChunkSize);
+		n = fread(&buf[len], 1, ChunkSize, file);
+		buf.resize(len + n);
+		Bytes += n;
+		if (n > 0) OpenLine = buf.back() != '\n';
+		if (n < ChunkSize)
+		{
+			if (ferror(file)) return false;
+			eof = true;
+		}
+
+		//Only complete lines are processed, the rest waits for the next chunk
+		begin = buf.data();
+		end = begin + buf.size();
+		if (eof == false)
+		{
+			while (end > begin && end[-1] != '\n') end--;
+			if (end == begin) continue;
+		}
+
+		p = counted = begin;
+		KeptSize = Kept.size();
+		while ((key = scan.FindKey(p, end)) != end)
+		{
+			line = key;
+			while (line > begin && IsBlank(line[-1])) line--;
+			eol = (const char *)memchr(key, '\n', end - key);
+			if (eol == nullptr) eol = end;
+			p = eol;
+			if (line > begin && line[-1] != '\n') continue;
+
+			LineNum += (unsigned)scan.CountLines(counted, line);
+			counted = line;
+			KeptLines.push_back({ Kept.size(), LineNum });
+			Kept.append(line, eol - line);
+			Kept.push_back('\n');
+		}
+		LineNum += (unsigned)scan.CountLines(counted, end);
+		buf.erase(0, end - begin);
+
+		//The lines of each chunk are indexed right away, so that reading can stop early
+		Index(std::string_view(Kept).substr(KeptSize), KeptSize);
+		if (Resolved == SchemaSize) break;
+	}
+
+	//The writer of a pipe fails if the rest isn't read
+	while (eof == false)
+	{
+		buf.resize(ChunkSize);
+		n = fread(&buf[0], 1, ChunkSize, file);
+		Bytes += n;
+		if (n < ChunkSize)
+		{
+			if (ferror(file)) return false;
+			eof = true;
+		}
+	}
+
+	Text = Kept;
+
+	//Reading and scanning overlap, all of it counts as scan time
+	if (stats)
+	{
+		stats->Scan += StatsClock() - start;
+		stats->Bytes += Bytes;
+		stats->Lines += LineNum - 1 + (OpenLine && Resolved < SchemaSize ? 1 : 0);
+		stats->Keys += Resolved;
+	}
+	return true;
+}
+
+void ScenarioIndex::Reset()
+{
+	ScenarioValue none;
+	none.Value = 0.0;
+	none.Offset = NoOffset;
+	none.Valid = false;
+
+	Values.assign(SchemaSize, none);
+	Resolved = 0;
+	Hash = HashSeed;
+	Kept.clear();
+	KeptLines.clear();
+	Extracted.clear();
+}
+
+size_t ScenarioIndex::Index(std::string_view text, size_t Base)
+{
+	const LineScanner &scan = GetLineScanner();
+	const char *begin = text.data();
+	const char *end = begin + text.size();
+	const char *p = begin;
+	const char *line, *eol, *key, *value;
+	int i;
+
+	while (Resolved < SchemaSize && (key = scan.FindKey(p, end)) != end)
+	{
+		//The key has to be the first token of the line
+		line = key;
+		while (line > begin && IsBlank(line[-1])) line--;
+		if (line > begin && line[-1] != '\n')
+		{
+			p = key + 5;
+			continue;
+		}
+
+		eol = (const char *)memchr(key, '\n', end - key);
+		if (eol == nullptr) eol = end;
+
+		p = key + 5;
+		while (p < eol && !IsBlank(*p)) p++;
+
+		//The first line of a key with a valid value counts. A line without one is kept until a later line of the key
+		//has a valid value, so that it can be reported if none has.
+		i = SchemaLookup(key, p - key);
+		if (i >= 0 && Values[i].Valid == false)
+		{
+			ScenarioValue &v = Values[i];
+			const char *last = p;
+			double val = 0.0;
+
+			while (p < eol && IsBlank(*p)) p++;
+			value = p;
+			while (p < eol && !IsBlank(*p)) p++;
+
+			if (ParseValue(value, p, val))
+			{
+				v.Value = val;
+				v.Valid = true;
+				v.Offset = Base + (value - begin);
+				Resolved++;
+			}
+			else if (v.Offset == NoOffset)
+			{
+				v.Offset = Base + (value - begin);
+			}
+			//Tokens only, a change of the blanks between them doesn't change the cards
+			Hash = HashBytes(Hash, key, last - key);
+			Hash = HashBytes(Hash, " ", 1);
+			Hash = HashBytes(Hash, value, p - value);
+			Hash = HashBytes(Hash, "\n", 1);
+		}
+		p = eol < end ? eol + 1 : end;
+	}
+	return Resolved < SchemaSize ? text.size() : p - begin;
+}
+
+const ScenarioValue *ScenarioIndex::Find(std::string_view Key) const
+{
+	int i = SchemaIndex(Key);
+	if (i < 0 || Values[i].Offset == NoOffset) return nullptr;
+	return &Values[i];
+}
+
+int ScenarioIndex::SchemaIndex(std::string_view Key)
+{
+	if (Key.substr(0, 5) != "LVDC_") return -1;
+	return SchemaLookup(Key.data(), Key.size());
+}
+
+//Lines are only counted for error messages, so loading a scenario doesn't have to
+void ScenarioIndex::Locate(const ScenarioValue &v, unsigned &Line, unsigned &Column) const
+{
+	const char *pos = Text.data() + v.Offset;
+	const char *line = pos;
+
+	while (line > Text.data() && line[-1] != '\n') line--;
+	Column = (unsigned)(pos - line) + 1;
+
+	if (KeptLines.empty())
+	{
+		Line = (unsigned)GetLineScanner().CountLines(Text.data(), line) + 1;
+		return;
+	}
+	//Streamed scenario, the line numbers were counted while reading
+	auto it = std::lower_bound(KeptLines.begin(), KeptLines.end(), std::make_pair((size_t)(line - Text.data()), 0U));
+	Line = it->second;
+}
+
+LookupStatus SearchForDouble(const ScenarioIndex &file, std::string_view str, double &val, double defval)
+{
+	const ScenarioValue *v = file.Find(str);
+
+	if (v && v->Valid)
+	{
+		val = v->Value;
+		return LookupStatus::Found;
+	}
+	val = defval;
+	return v ? LookupStatus::Malformed : LookupStatus::Defaulted;
+}
+
+void AddError(std::vector<ScenarioError> &errors, const ScenarioIndex &file, std::string_view Key)
+{
+	for (size_t i = 0; i < errors.size(); i++)
+	{
+		if (errors[i].Key == Key) return;
+	}
+
+	ScenarioError err;
+	err.Key = Key;
+	file.Locate(*file.Find(Key), err.Line, err.Column);
+	errors.push_back(err);
+}
+
+//Parses a right-justified card field
+static bool ParseField(const char *p, size_t len, double &val)
+{
+	const char *last = p + len;
+	while (p < last && *p == ' ') p++;
+	return ParseValue(p, last, val);
+}
+
+//Parses the 12 column card ID, YYDDD, then the opportunity and card number
+static bool ParseCardID(const char *p, DeckCard &card)
+{
+	const char *last = p + 12;
+	while (p < last && *p == ' ') p++;
+	if (last - p < 9) return false;
+	for (const char *c = p; c < last; c++)
+	{
+		if (*c < '0' || *c > '9') return false;
+	}
+	std::from_chars(p, p + 2, card.Year);
+	std::from_chars(p + 2, p + 5, card.LaunchDay);
+	std::from_chars(p + 5, p + 6, card.Opp);
+	return std::from_chars(p + 6, last, card.Card).ec == std::errc();
+}
+
+//Largest rounding error of a value written with 9 significant digits
+static double CardRounding(double val)
+{
+	if (val == 0.0 || std::isfinite(val) == false) return 0.0;
+	return 0.5e-8 * std::pow(10.0, std::floor(std::log10(std::fabs(val))));
+}
+
+bool TLIDeck::Fail(unsigned Line, const char *Msg)
+{
+	ErrorLine = Line;
+	Error = Msg;
+	return false;
+}
+
+bool TLIDeck::Load(const std::string &FileName)
+{
+	MappedFile Map;
+	DeckCard card;
+	double raw[4], tol[4];
+	const char *p, *end, *eol;
+	size_t len;
+	unsigned LineNum = 0;
+	int s, f, pass;
+
+	CardArr.clear();
+	CardIndex.clear();
+	LaunchDayArr.clear();
+	Values.clear();
+	ValueIndex.clear();
+	Error.clear();
+	ErrorLine = 0;
+
+	if (Map.Open(FileName) == false) return Fail(0, "not found");
+
+	p = Map.Data().data();
+	end = p + Map.Data().size();
+
+	while (p < end)
+	{
+		LineNum++;
+		eol = (const char *)memchr(p, '\n', end - p);
+		if (eol == nullptr) eol = end;
+		len = eol - p;
+		if (len > 0 && p[len - 1] == '\r') len--;
+
+		if (len != 80) return Fail(LineNum, "card is not 80 columns wide");
+		for (f = 0; f < 4; f++)
+		{
+			if (ParseField(p + 17 * f, 17, card.Field[f]) == false) return Fail(LineNum, "field is not a number");
+		}
+		if (ParseCardID(p + 68, card) == false) return Fail(LineNum, "invalid card ID");
+		p = eol + 1;
+
+		//Position in the layout follows from the card number
+		if (card.Card < SectionFirstCard[0]) return Fail(LineNum, "invalid card number");
+		s = card.Card >= SectionFirstCard[2] ? 2 : card.Card >= SectionFirstCard[1] ? 1 : 0;
+		size_t k = (size_t)(card.Card - SectionFirstCard[s]);
+		size_t day = k / SectionSize[s];
+		const CardDesc &desc = SectionLayout[s][k % SectionSize[s]];
+
+		if (card.Opp != desc.Opp) return Fail(LineNum, "wrong opportunity for the card number");
+		if (CardArr.empty() == false && card.Year != CardArr.front().Year) return Fail(LineNum, "year differs from the first card");
+		if (CardIndex.emplace(card.Card, CardArr.size()).second == false) return Fail(LineNum, "card number is used twice");
+
+		if (day >= Values.size())
+		{
+			Values.resize(day + 1);
+			ValueIndex.resize(day + 1);
+			LaunchDayArr.resize(day + 1, -1);
+		}
+		if (LaunchDayArr[day] < 0) LaunchDayArr[day] = card.LaunchDay;
+		else if (LaunchDayArr[day] != card.LaunchDay) return Fail(LineNum, "launch day differs from the other cards of this day");
+
+		//Fields with a reference need the other presettings first
+		for (pass = 0; pass < 2; pass++)
+		{
+			for (f = 0; f < 4; f++)
+			{
+				const FieldDesc &field = desc.Field[f];
+
+				if ((field.Conv == FieldConv::GRRAngle) != (pass == 1)) continue;
+
+				switch (field.Type)
+				{
+				case FieldType::LaunchDay:
+					if (card.Field[f] != card.LaunchDay) return Fail(LineNum, "launch day field differs from the card ID");
+					break;
+				case FieldType::Opp:
+					if (card.Field[f] != card.Opp) return Fail(LineNum, "opportunity field differs from the card ID");
+					break;
+				default:
+					raw[f] = RevertField(field.Conv, card.Field, raw, f, field.Ref);
+					//Half a unit in the 9th digit, with some room for the rounding of the conversions
+					tol[f] = CardRounding(card.Field[f]) / FieldScale(field.Conv) + 1e-14 * std::fabs(raw[f]);
+					if (field.Conv == FieldConv::GRRAngle) tol[f] += DT_GRR * tol[field.Ref];
+					Values[day].push_back(DeckValue{ raw[f], tol[f], card.Card, f, &field });
+					break;
+				}
+			}
+		}
+		CardArr.push_back(card);
+	}
+
+	if (CardArr.empty()) return Fail(0, "no cards");
+
+	for (size_t day = 0; day < Values.size(); day++)
+	{
+		std::sort(Values[day].begin(), Values[day].end(), [](const DeckValue &a, const DeckValue &b) { return a.Card != b.Card ? a.Card < b.Card : a.Field < b.Field; });
+		for (size_t i = 0; i < Values[day].size(); i++)
+		{
+			ValueIndex[day].emplace(Values[day][i].Desc->Key.View(), i);
+		}
+	}
+
+	//Every launch day needs all cards of all sections
+	for (size_t day = 0; day < Values.size(); day++)
+	{
+		for (s = 0; s < 3; s++)
+		{
+			for (size_t k = 0; k < SectionSize[s]; k++)
+			{
+				if (CardIndex.count(SectionFirstCard[s] + (int)(day * SectionSize[s] + k)) == 0) return Fail(0, "cards are missing");
+			}
+		}
+	}
+	return true;
+}
+
+const DeckCard *TLIDeck::FindCard(int Card) const
+{
+	auto it = CardIndex.find(Card);
+	if (it == CardIndex.end()) return nullptr;
+	return &CardArr[it->second];
+}
+
+const DeckValue *TLIDeck::FindPresetting(size_t Day, std::string_view Key) const
+{
+	auto it = ValueIndex[Day].find(Key);
+	if (it == ValueIndex[Day].end()) return nullptr;
+	return &Values[Day][it->second];
+}
+
+//Readers of binary decks check the header against the layout of the converter
+static_assert(TLIBinaryMaxDays == MaxDeckDays, "Launch days of a binary deck");
+static_assert(TLIBinaryFirstCard[0] == SectionFirstCard[0] && TLIBinaryFirstCard[1] == SectionFirstCard[1] && TLIBinaryFirstCard[2] == SectionFirstCard[2], "First cards of a binary deck");
+static_assert(TLIBinarySectionCards[0] == SectionSize[0] && TLIBinarySectionCards[1] == SectionSize[1] && TLIBinarySectionCards[2] == SectionSize[2], "Cards per launch day of a binary deck");
+
+bool WriteBinaryDeck(const DeckJob &job, const ScenarioCards *cards, std::string &out, std::string &Error)
+{
+	TLIBinaryHeader h{};
+	size_t Days = job.LaunchDayArr.size();
+
+	memcpy(h.Magic, TLIBinaryMagic, sizeof(h.Magic));
+	h.Version = TLIBinaryVersion;
+	h.HeaderSize = sizeof(TLIBinaryHeader);
+	h.RecordSize = sizeof(TLIBinaryCard);
+	h.Year = (uint32_t)job.Year;
+	h.Days = (uint32_t)Days;
+	h.Cards = (uint32_t)DeckSize(cards, Days);
+	for (int s = 0; s < 3; s++)
+	{
+		h.FirstCard[s] = (uint32_t)SectionFirstCard[s];
+		h.SectionCards[s] = (uint32_t)SectionSize[s];
+	}
+
+	out.reserve(out.size() + sizeof(h) + h.Cards * sizeof(TLIBinaryCard));
+	out.append((const char *)&h, sizeof(h));
+
+	//The values as a reader of the text deck gets them
+	return ForEachDeckCard(job.Year, job.LaunchDayArr, cards, Error, [&](const CardRecord &card)
+	{
+		TLIBinaryCard rec{};
+		DeckCard id;
+
+		ParseCardID(card.Text + 68, id);
+		rec.Year = (uint16_t)id.Year;
+		rec.LaunchDay = (uint16_t)id.LaunchDay;
+		rec.Opp = (uint16_t)id.Opp;
+		rec.Card = (uint16_t)id.Card;
+		for (int f = 0; f < 4; f++)
+		{
+			if (ParseField(card.Text + 17 * f, 17, rec.Field[f]) == false) rec.Field[f] = std::numeric_limits<double>::quiet_NaN();
+		}
+		out.append((const char *)&rec, sizeof(rec));
+	});
+}
+
+//Card ID as one number, for matching the cards of two decks
+static uint64_t CardKey(const DeckCard &card)
+{
+	return (((uint64_t)card.Year * 1000 + (uint64_t)card.LaunchDay) * 10 + (uint64_t)card.Opp) * 100000 + (uint64_t)card.Card;
+}
+
+//Cards of a deck in file order with their keys, and their index by key
+static bool IndexDeck(std::string_view Data, std::vector<std::pair<uint64_t, const char *>> &Cards, std::unordered_map<uint64_t, size_t> &Index, std::string &Error)
+{
+	const char *p = Data.data(), *end = p + Data.size(), *eol;
+	DeckCard card;
+	unsigned LineNum = 0;
+	size_t len;
+
+	while (p < end)
+	{
+		LineNum++;
+		eol = (const char *)memchr(p, '\n', end - p);
+		if (eol == nullptr) eol = end;
+		len = eol - p;
+		if (len > 0 && p[len - 1] == '\r') len--;
+
+		if (len != 80)
+		{
+			Error = "line " + std::to_string(LineNum) + ": card is not 80 columns wide";
+			return false;
+		}
+		if (ParseCardID(p + 68, card) == false)
+		{
+			Error = "line " + std::to_string(LineNum) + ": invalid card ID";
+			return false;
+		}
+		if (Index.emplace(CardKey(card), Cards.size()).second == false)
+		{
+			Error = "line " + std::to_string(LineNum) + ": card ID is used twice";
+			return false;
+		}
+		Cards.push_back({ CardKey(card), p });
+		p = eol + 1;
+	}
+	return true;
+}
+
+//ID of a card without the blanks in front
+static std::string CardIDText(const char *card)
+{
+	size_t i = 68;
+	while (i < 80 && card[i] == ' ') i++;
+	return std::string(card + i, 80 - i);
+}
+
+bool DiffDecks(const std::string &OldFile, const std::string &NewFile, std::vector<CardChange> &Changes, std::string &Error)
+{
+	MappedFile OldMap, NewMap;
+	std::vector<std::pair<uint64_t, const char *>> OldCards, NewCards;
+	std::unordered_map<uint64_t, size_t> OldIndex, NewIndex;
+
+	if (OldMap.Open(OldFile) == false)
+	{
+		Error = OldFile + " not found";
+		return false;
+	}
+	if (NewMap.Open(NewFile) == false)
+	{
+		Error = NewFile + " not found";
+		return false;
+	}
+	if (IndexDeck(OldMap.Data(), OldCards, OldIndex, Error) == false)
+	{
+		Error = OldFile + " " + Error;
+		return false;
+	}
+	if (IndexDeck(NewMap.Data(), NewCards, NewIndex, Error) == false)
+	{
+		Error = NewFile + " " + Error;
+		return false;
+	}
+
+	for (size_t i = 0; i < NewCards.size(); i++)
+	{
+		const char *card = NewCards[i].second;
+		auto it = OldIndex.find(NewCards[i].first);
+		unsigned Fields = 0;
+
+		if (it == OldIndex.end())
+		{
+			Changes.push_back({ CardIDText(card), std::string(), std::string(card, 80), 0xF });
+			continue;
+		}
+
+		//Same card ID, so only the fields can differ
+		const char *old = OldCards[it->second].second;
+		for (int f = 0; f < 4; f++)
+		{
+			if (memcmp(card + 17 * f, old + 17 * f, 17) != 0) Fields |= 1 << f;
+		}
+		if (Fields) Changes.push_back({ CardIDText(card), std::string(old, 80), std::string(card, 80), Fields });
+	}
+	for (size_t i = 0; i < OldCards.size(); i++)
+	{
+		const char *card = OldCards[i].second;
+		if (NewIndex.count(OldCards[i].first) == 0) Changes.push_back({ CardIDText(card), std::string(card, 80), std::string(), 0xF });
+	}
+	return true;
+}
+
+//Existing file, read and written at offsets
+class DeckFile
+{
+public:
+	DeckFile(const DeckFile &) = delete;
+	DeckFile &operator=(const DeckFile &) = delete;
+#ifdef _WIN32
+	DeckFile() : hFile(INVALID_HANDLE_VALUE) {}
+	~DeckFile() { if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile); }
+
+	bool Open(const std::string &FileName)
+	{
+		hFile = CreateFileA(FileName.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		return hFile != INVALID_HANDLE_VALUE;
+	}
+	uint64_t Size()
+	{
+		LARGE_INTEGER size;
+		return GetFileSizeEx(hFile, &size) ? (uint64_t)size.QuadPart : 0;
+	}
+	bool Read(uint64_t Offset, char *Data, size_t Len)
+	{
+		OVERLAPPED ov{};
+		DWORD done = 0;
+		ov.Offset = (DWORD)Offset;
+		ov.OffsetHigh = (DWORD)(Offset >> 32);
+		return ReadFile(hFile, Data, (DWORD)Len, &done, &ov) && done == Len;
+	}
+	bool Write(uint64_t Offset, const char *Data, size_t Len)
+	{
+		OVERLAPPED ov{};
+		DWORD done = 0;
+		ov.Offset = (DWORD)Offset;
+		ov.OffsetHigh = (DWORD)(Offset >> 32);
+		return WriteFile(hFile, Data, (DWORD)Len, &done, &ov) && done == Len;
+	}
+	bool Flush() { return FlushFileBuffers(hFile) != FALSE; }
+protected:
+	HANDLE hFile;
+#else
+	DeckFile() : fd(-1) {}
+	~DeckFile() { if (fd >= 0) close(fd); }
+
+	bool Open(const std::string &FileName)
+	{
+		fd = open(FileName.c_str(), O_RDWR);
+		return fd >= 0;
+	}
+	uint64_t Size()
+	{
+		struct stat st;
+		return fstat(fd, &st) == 0 ? (uint64_t)st.st_size : 0;
+	}
+	bool Read(uint64_t Offset, char *Data, size_t Len)
+	{
+		while (Len > 0)
+		{
+			ssize_t n = pread(fd, Data, Len, (off_t)Offset);
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0) return false;
+			Data += n;
+			Offset += (uint64_t)n;
+			Len -= (size_t)n;
+		}
+		return true;
+	}
+	bool Write(uint64_t Offset, const char *Data, size_t Len)
+	{
+		while (Len > 0)
+		{
+			ssize_t n = pwrite(fd, Data, Len, (off_t)Offset);
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0) return false;
+			Data += n;
+			Offset += (uint64_t)n;
+			Len -= (size_t)n;
+		}
+		return true;
+	}
+	bool Flush() { return fsync(fd) == 0; }
+protected:
+	int fd;
+#endif
+};
+
+bool PatchDeck(const DeckJob &job, const ScenarioCards *cards, std::string &Error)
+{
+	const size_t DayCards = SectionSize[0] + SectionSize[1] + SectionSize[2];
+	DeckFile file;
+	DeckCard card;
+	char line[82];
+	size_t i, j, k;
+	int s;
+
+	if (job.FileNameOut == StdStream || file.Open(job.FileNameOut) == false)
+	{
+		Error = "not found";
+		return false;
+	}
+
+	//The deck keeps its line ends, so all cards have the length of the first one
+	uint64_t Size = file.Size();
+	size_t len = Size < sizeof(line) ? (size_t)Size : sizeof(line);
+	size_t Stride = 0;
+	if (file.Read(0, line, len))
+	{
+		if (len >= 81 && line[80] == '\n') Stride = 81;
+		else if (len >= 82 && line[80] == '\r' && line[81] == '\n') Stride = 82;
+	}
+	if (Stride == 0)
+	{
+		Error = "card is not 80 columns wide";
+		return false;
+	}
+	if (Size % (Stride * DayCards) != 0)
+	{
+		Error = "deck isn't a whole number of launch days";
+		return false;
+	}
+	size_t Days = (size_t)(Size / (Stride * DayCards));
+
+	//Reads the ID of the card on a line, and checks that it's the card the deck order puts there
+	auto CheckCard = [&](size_t Line, int Card, int LaunchDay) -> bool
+	{
+		if (file.Read(Line * Stride + 68, line, 12) == false || ParseCardID(line, card) == false)
+		{
+			Error = "line " + std::to_string(Line + 1) + ": invalid card ID";
+			return false;
+		}
+		if (card.Year != job.Year % 100)
+		{
+			Error = "deck is for year " + std::to_string(card.Year) + " instead of " + std::to_string(job.Year % 100);
+			return false;
+		}
+		if (card.Card != Card || (LaunchDay >= 0 && card.LaunchDay != LaunchDay))
+		{
+			Error = "line " + std::to_string(Line + 1) + ": card " + std::to_string(card.Card) + " isn't in deck order";
+			return false;
+		}
+		return true;
+	};
+
+	//Launch days of the deck, from the first card of each
+	std::vector<int> DeckDays(Days);
+	for (i = 0; i < Days; i++)
+	{
+		if (CheckCard(i * SectionSize[0], SectionFirstCard[0] + (int)(i * SectionSize[0]), -1) == false) return false;
+		DeckDays[i] = card.LaunchDay;
+	}
+
+	//Position of each launch day in the deck. All are checked before anything is written.
+	std::vector<size_t> Pos(job.LaunchDayArr.size());
+	for (j = 0; j < job.LaunchDayArr.size(); j++)
+	{
+		auto it = std::find(DeckDays.begin(), DeckDays.end(), job.LaunchDayArr[j]);
+		if (it == DeckDays.end())
+		{
+			Error = "no launch day " + std::to_string(job.LaunchDayArr[j]);
+			return false;
+		}
+		Pos[j] = it - DeckDays.begin();
+
+		size_t first = 0;
+		for (s = 0; s < 3; s++)
+		{
+			size_t Line = first + Pos[j] * SectionSize[s];
+			int Card = SectionFirstCard[s] + (int)(Pos[j] * SectionSize[s]);
+
+			if (cards[j].Section[s].size() != SectionSize[s])
+			{
+				Error = "cards of launch day " + std::to_string(job.LaunchDayArr[j]) + " don't fit the layout";
+				return false;
+			}
+			//The other cards of a section lie in between
+			if (CheckCard(Line, Card, job.LaunchDayArr[j]) == false) return false;
+			if (CheckCard(Line + SectionSize[s] - 1, Card + (int)SectionSize[s] - 1, job.LaunchDayArr[j]) == false) return false;
+			first += Days * SectionSize[s];
+		}
+	}
+
+	//The cards of a launch day are one block per section
+	std::string out;
+	char ID[32];
+	for (j = 0; j < job.LaunchDayArr.size(); j++)
+	{
+		snprintf(ID, sizeof(ID), "%02d%03d", job.Year % 100, job.LaunchDayArr[j]);
+
+		size_t first = 0;
+		for (s = 0; s < 3; s++)
+		{
+			size_t Line = first + Pos[j] * SectionSize[s];
+			int Card = SectionFirstCard[s] + (int)(Pos[j] * SectionSize[s]);
+
+			out.clear();
+			for (k = 0; k < SectionSize[s]; k++)
+			{
+				CardRecord rec = cards[j].Section[s][k];
+				if (FormatID(rec.Text + 68, ID, rec.Opp, Card + (int)k) == false)
+				{
+					Error = "the ID of card " + std::to_string(Card + (int)k) + " for launch day " + std::to_string(job.LaunchDayArr[j]) + " is wider than 12 columns";
+					return false;
+				}
+				out.append(rec.Text, 80);
+				out.append(Stride == 82 ? "\r\n" : "\n");
+			}
+			if (file.Write(Line * Stride, out.data(), out.size()) == false)
+			{
+				Error = "write failed";
+				return false;
+			}
+			first += Days * SectionSize[s];
+		}
+	}
+	if (file.Flush() == false)
+	{
+		Error = "write failed";
+		return false;
+	}
+	return true;
+}
+
+//Cache file header. The version covers the card formatting, changes of the layout tables are found by their hash.
+constexpr char CacheMagic[8] = { 'T', 'L', 'I', 'C', 'A', 'C', 'H', 'E' };
+constexpr uint32_t CacheVersion = 1;
+//Entries that weren't used in this many runs are dropped
+constexpr uint32_t CacheKeepRuns = 16;
+
+//Size of a card in the cache file, the text and the opportunity
+constexpr size_t CacheCardSize = 80 + 1;
+constexpr size_t CacheHeaderSize = sizeof(CacheMagic) + 4 + 4 + 8 + 8;
+constexpr size_t CacheEntrySize = 8 + 4 + (Section1Cards.size() + Section2Cards.size() + Section3Cards.size()) * CacheCardSize;
+
+//Hash of the layout tables, cached cards from another layout don't match
+static uint64_t LayoutHash()
+{
+	uint64_t h = HashSeed;
+
+	for (int s = 0; s < 3; s++)
+	{
+		for (size_t k = 0; k < SectionSize[s]; k++)
+		{
+			const CardDesc &desc = SectionLayout[s][k];
+
+			h = HashBytes(h, &desc.Opp, sizeof(desc.Opp));
+			for (int f = 0; f < 4; f++)
+			{
+				const FieldDesc &field = desc.Field[f];
+				int Type = (int)field.Type, Conv = (int)field.Conv;
+
+				h = HashBytes(h, &Type, sizeof(Type));
+				h = HashBytes(h, field.Key.Str, field.Key.Len + 1);
+				h = HashBytes(h, &field.Default, sizeof(field.Default));
+				h = HashBytes(h, &Conv, sizeof(Conv));
+				h = HashBytes(h, &field.Ref, sizeof(field.Ref));
+			}
+		}
+	}
+	return h;
+}
+
+CardCache::CardCache() : Run(1), Changed(false)
+{
+}
+
+void CardCache::Load(const std::string &File)
+{
+	MappedFile Map;
+	uint32_t Version;
+	uint64_t Layout, Count;
+
+	FileName = File;
+	Entries.clear();
+	Run = 1;
+	Changed = false;
+
+	if (Map.Open(FileName) == false) return;
+
+	const char *p = Map.Data().data();
+	size_t size = Map.Data().size();
+
+	if (size < CacheHeaderSize || memcmp(p, CacheMagic, sizeof(CacheMagic))) return;
+	p += sizeof(CacheMagic);
+	memcpy(&Version, p, 4);
+	memcpy(&Run, p + 4, 4);
+	memcpy(&Layout, p + 8, 8);
+	memcpy(&Count, p + 16, 8);
+	p += 24;
+
+	if (Version != CacheVersion || Layout != LayoutHash() || size != CacheHeaderSize + Count * CacheEntrySize)
+	{
+		Run = 1;
+		return;
+	}
+
+	for (uint64_t i = 0; i < Count; i++)
+	{
+		uint64_t key;
+		Entry e;
+
+		memcpy(&key, p, 8);
+		memcpy(&e.LastRun, p + 8, 4);
+		p += 12;
+		for (int s = 0; s < 3; s++)
+		{
+			e.Section[s].resize(SectionSize[s]);
+			for (size_t k = 0; k < SectionSize[s]; k++)
+			{
+				memcpy(e.Section[s][k].Text, p, 80);
+				e.Section[s][k].Text[80] = '\0';
+				e.Section[s][k].Opp = p[80];
+				p += CacheCardSize;
+			}
+		}
+		Entries.emplace(key, std::move(e));
+	}
+	Run++;
+}
+
+bool CardCache::Save()
+{
+	if (FileName.empty()) return true;
+
+	for (auto it = Entries.begin(); it != Entries.end();)
+	{
+		if (Run - it->second.LastRun >= CacheKeepRuns)
+		{
+			it = Entries.erase(it);
+			Changed = true;
+		}
+		else it++;
+	}
+	if (Changed == false) return true;
+
+	std::string out;
+	uint64_t Layout = LayoutHash(), Count = Entries.size();
+
+	out.reserve(CacheHeaderSize + Count * CacheEntrySize);
+	out.append(CacheMagic, sizeof(CacheMagic));
+	out.append((const char *)&CacheVersion, 4);
+	out.append((const char *)&Run, 4);
+	out.append((const char *)&Layout, 8);
+	out.append((const char *)&Count, 8);
+
+	for (const auto &it : Entries)
+	{
+		out.append((const char *)&it.first, 8);
+		out.append((const char *)&it.second.LastRun, 4);
+		for (int s = 0; s < 3; s++)
+		{
+			for (const CardRecord &card : it.second.Section[s])
+			{
+				out.append(card.Text, 80);
+				out.push_back((char)card.Opp);
+			}
+		}
+	}
+
+	if (WriteFileAtomic(FileName, out) == false) return false;
+	Changed = false;
+	return true;
+}
+
+bool CardCache::Find(uint64_t Key, ScenarioCards &cards)
+{
+	if (FileName.empty()) return false;
+
+	std::lock_guard<std::mutex> lock(Mutex);
+	auto it = Entries.find(Key);
+	if (it == Entries.end()) return false;
+
+	if (it->second.LastRun != Run)
+	{
+		it->second.LastRun = Run;
+		Changed = true;
+	}
+	for (int s = 0; s < 3; s++)
+	{
+		cards.Section[s] = it->second.Section[s];
+	}
+	return true;
+}
+
+void CardCache::Insert(uint64_t Key, const ScenarioCards &cards)
+{
+	if (FileName.empty()) return;
+
+	std::lock_guard<std::mutex> lock(Mutex);
+	Entry &e = Entries[Key];
+	for (int s = 0; s < 3; s++)
+	{
+		e.Section[s] = cards.Section[s];
+	}
+	e.LastRun = Run;
+	Changed = true;
+}
+
+uint64_t CardCache::Key(uint64_t ContentHash, int LaunchDay)
+{
+	return HashBytes(ContentHash, &LaunchDay, sizeof(LaunchDay));
+}
+
+uint64_t CardInterner::Key(const CardDesc &desc, const double raw[4], int LaunchDay, Entry &e)
+{
+	bool ShowsDay = false;
+
+	e.Desc = &desc;
+	for (int f = 0; f < 4; f++)
+	{
+		memcpy(&e.Raw[f], &raw[f], sizeof(double));
+		if (desc.Field[f].Type == FieldType::LaunchDay) ShowsDay = true;
+	}
+	//The other cards are the same on all launch days
+	e.LaunchDay = ShowsDay ? LaunchDay : 0;
+
+	uint64_t h = HashBytes(HashSeed, &e.Desc, sizeof(e.Desc));
+	h = HashBytes(h, e.Raw, sizeof(e.Raw));
+	return HashBytes(h, &e.LaunchDay, sizeof(e.LaunchDay));
+}
+
+bool CardInterner::Find(const CardDesc &desc, const double raw[4], int LaunchDay, char *Text)
+{
+	Entry e;
+	uint64_t h = Key(desc, raw, LaunchDay, e);
+
+	std::lock_guard<std::mutex> lock(Mutex);
+	auto it = Entries.find(h);
+	if (it == Entries.end()) return false;
+
+	const Entry &found = it->second;
+	if (found.Desc != e.Desc || found.LaunchDay != e.LaunchDay || memcmp(found.Raw, e.Raw, sizeof(e.Raw)) != 0) return false;
+	memcpy(Text, found.Text, sizeof(found.Text));
+	return true;
+}
+
+void CardInterner::Insert(const CardDesc &desc, const double raw[4], int LaunchDay, const char *Text)
+{
+	Entry e;
+	uint64_t h = Key(desc, raw, LaunchDay, e);
+	memcpy(e.Text, Text, sizeof(e.Text));
+
+	//On a hash collision the first card stays
+	std::lock_guard<std::mutex> lock(Mutex);
+	Entries.emplace(h, e);
+}
+
+void PresettingStore::Reset(size_t Days)
+{
+	DayCount = Days;
+	Stride = (Days + 3) & ~(size_t)3;
+	RawCols.assign(SchemaSize * Stride, 0.0);
+	ConvCols.assign(SchemaSize * Stride, 0.0);
+}
+
+void PresettingStore::Extract(size_t Day, const ScenarioIndex &in, std::vector<ScenarioError> &errors, RunStats *stats)
+{
+	double start = stats ? StatsClock() : 0.0;
+
+	for (size_t k = 0; k < SchemaSize; k++)
+	{
+		const ScenarioValue *v = in.FindIndex(k);
+		double &raw = RawCols[k * Stride + Day];
+
+		if (v && v->Valid)
+		{
+			raw = v->Value;
+			if (stats) stats->Found++;
+			continue;
+		}
+		raw = Schema.Desc[k]->Default;
+		if (v)
+		{
+			AddError(errors, in, Schema.Desc[k]->Key.View());
+			if (stats) stats->Malformed++;
+		}
+		else if (stats) stats->Defaulted++;
+	}
+
+	if (stats) stats->Lookup += StatsClock() - start;
+}
+
+void PresettingStore::Convert(RunStats *stats)
+{
+	const ConvertKernel &kernel = GetConvertKernel();
+	double start = stats ? StatsClock() : 0.0;
+
+	for (size_t k = 0; k < SchemaSize; k++)
+	{
+		double *col = ConvCols.data() + k * Stride;
+		FieldConv Conv = Schema.Desc[k]->Conv;
+
+		std::copy(RawCols.begin() + k * Stride, RawCols.begin() + (k + 1) * Stride, col);
+		if (Conv == FieldConv::GRRAngle)
+		{
+			kernel.MulAdd(col, RawCols.data() + SchemaFields.Ref[k] * Stride, Stride, DT_GRR);
+			continue;
+		}
+		for (const ConvStep &step : ConvSteps(Conv))
+		{
+			if (step.Op) kernel.Apply(col, Stride, step.Op, step.C);
+		}
+	}
+
+	if (stats) stats->Convert += StatsClock() - start;
+}
+
+void PresettingStore::Render(size_t Day, int LaunchDay, ScenarioCards &cards, CardInterner *intern, RunStats *stats) const
+{
+	double start = stats ? StatsClock() : 0.0;
+	//Fields without a presetting are 0, for the interner
+	double raw[4];
+	int f;
+
+	for (int s = 0; s < 3; s++)
+	{
+		cards.Section[s].resize(SectionSize[s]);
+
+		for (size_t i = 0; i < SectionSize[s]; i++)
+		{
+			const CardDesc &desc = SectionLayout[s][i];
+			const int16_t *key = SchemaFields.Key[SectionStart[s] + i];
+			CardRecord &card = cards.Section[s][i];
+
+			memset(card.Text + 68, ' ', 12);
+			card.Text[80] = '\0';
+			card.Opp = desc.Opp;
+
+			if (intern)
+			{
+				for (f = 0; f < 4; f++) raw[f] = key[f] >= 0 ? Raw(key[f], Day) : 0.0;
+				if (intern->Find(desc, raw, LaunchDay, card.Text))
+				{
+					if (stats) stats->Interned++;
+					continue;
+				}
+			}
+
+			for (f = 0; f < 4; f++)
+			{
+				switch (desc.Field[f].Type)
+				{
+				case FieldType::LaunchDay:
+					FormatInt(card.Text + 17 * f, LaunchDay);
+					break;
+				case FieldType::Opp:
+					FormatInt(card.Text + 17 * f, desc.Opp);
+					break;
+				default:
+					FormatValue(card.Text + 17 * f, Converted(key[f], Day));
+					break;
+				}
+			}
+			if (intern) intern->Insert(desc, raw, LaunchDay, card.Text);
+		}
+	}
+
+	if (stats) stats->Format += StatsClock() - start;
+}
+
+bool ValidatePresettings(const PresettingStore &store, std::vector<PresettingViolation> &Violations)
+{
+	const CheckKernel &kernel = GetCheckKernel();
+	const size_t n = store.Days(), first = Violations.size();
+
+	for (const PresettingRule &rule : PresettingRules)
+	{
+		const double *a = rule.Key >= 0 ? store.RawColumn(rule.Key) : nullptr;
+		const double *b = rule.Key2 >= 0 ? store.RawColumn(rule.Key2) : nullptr;
+
+		switch (rule.Kind)
+		{
+		case RuleKind::Finite:
+			for (size_t k = 0; k < SchemaSize; k++)
+			{
+				a = store.RawColumn(k);
+				if (kernel.AnyNonFinite(a, n) == false) continue;
+				for (size_t d = 0; d < n; d++)
+				{
+					if (std::isfinite(a[d]) == false) Violations.push_back({ d, &rule, (int)k, a[d], 0.0 });
+				}
+			}
+			break;
+		case RuleKind::Range:
+			if (kernel.AnyOutside(a, n, rule.Lo, rule.Hi) == false) break;
+			for (size_t d = 0; d < n; d++)
+			{
+				if (std::isfinite(a[d]) && (a[d] < rule.Lo || a[d] > rule.Hi)) Violations.push_back({ d, &rule, rule.Key, a[d], 0.0 });
+			}
+			break;
+		case RuleKind::Order:
+			if (kernel.AnyAbove(a, b, n) == false) break;
+			for (size_t d = 0; d < n; d++)
+			{
+				if (std::isfinite(a[d]) && std::isfinite(b[d]) && a[d] > b[d]) Violations.push_back({ d, &rule, rule.Key, a[d], b[d] });
+			}
+			break;
+		}
+	}
+
+	std::stable_sort(Violations.begin() + first, Violations.end(), [](const PresettingViolation &x, const PresettingViolation &y) { return x.Day < y.Day; });
+	return Violations.size() == first;
+}
+
+std::string DescribeViolation(const PresettingViolation &v)
+{
+	std::ostringstream msg;
+
+	msg.precision(9);
+	msg << Schema.Desc[v.Key]->Key.View() << " is " << v.Value;
+	switch (v.Rule->Kind)
+	{
+	case RuleKind::Finite:
+		msg << ", not a finite number";
+		break;
+	case RuleKind::Range:
+		if (v.Rule->Hi == std::numeric_limits<double>::max()) msg << ", below " << v.Rule->Lo;
+		else msg << ", outside [" << v.Rule->Lo << ", " << v.Rule->Hi << "]";
+		break;
+	case RuleKind::Order:
+		msg << ", greater than " << Schema.Desc[v.Rule->Key2]->Key.View() << " at " << v.Value2;
+		break;
+	}
+	return msg.str();
+}
+
+bool ValidateDecks(const std::vector<DeckJob> &Jobs, ThreadPool &pool)
+{
+	//The rules don't depend on the launch day, so a scenario shared by decks is checked once
+	std::vector<std::string> Files;
+	std::unordered_map<std::string, size_t> Seen;
+
+	for (size_t j = 0; j < Jobs.size(); j++)
+	{
+		for (size_t i = 0; i < Jobs[j].FileNameInArr.size(); i++)
+		{
+			if (Seen.emplace(Jobs[j].FileNameInArr[i], Files.size()).second) Files.push_back(Jobs[j].FileNameInArr[i]);
+		}
+	}
+
+	std::vector<char> Found(Files.size());
+	std::vector<std::vector<ScenarioError>> Errors(Files.size());
+	std::vector<PresettingViolation> Violations;
+	PresettingStore store;
+	size_t Failed = 0, Count = 0;
+
+	store.Reset(Files.size());
+	ScenarioReader::Read(Files, pool, [&](size_t i, const std::string *Data)
+	{
+		ScenarioArena &arena = pool.Arena();
+		ArenaScope scope(arena);
+		ScenarioIndex in(arena.Resource());
+
+		if (Data) Found[i] = in.LoadRead(*Data);
+		else Found[i] = Files[i] == StdStream ? in.LoadStream(stdin) : in.Load(Files[i]);
+		if (Found[i]) store.Extract(i, in, Errors[i]);
+	});
+
+	ValidatePresettings(store, Violations);
+
+	//One line per problem, grouped by scenario
+	size_t v = 0;
+	for (size_t i = 0; i < Files.size(); i++)
+	{
+		bool failed = false;
+
+		if (Found[i] == false)
+		{
+			std::cout << "File " << Files[i] << " not found!" << std::endl;
+			failed = true;
+		}
+		for (size_t k = 0; k < Errors[i].size(); k++)
+		{
+			const ScenarioError &err = Errors[i][k];
+			std::cout << "File " << Files[i] << " line " << err.Line << " column " << err.Column << ": " << err.Key << " is not a number!" << std::endl;
+			failed = true;
+		}
+		//Rows of missing scenarios are empty
+		for (; v < Violations.size() && Violations[v].Day == i; v++)
+		{
+			if (Found[i] == false) continue;
+			std::cout << "File " << Files[i] << ": " << DescribeViolation(Violations[v]) << "!" << std::endl;
+			failed = true;
+			Count++;
+		}
+		if (failed) Failed++;
+	}
+
+	std::cout << Files.size() - Failed << " of " << Files.size() << " scenarios passed, " << Count << " rule violations!" << std::endl;
+	return Failed == 0;
+}
+
+bool FixedWidthString(char *dest, std::string_view str, unsigned len)
+{
+	//The field width is fixed, a longer string would shift the columns after it
+	if (str.length() > len) return false;
+
+	memset(dest, ' ', len - str.length());
+	memcpy(dest + len - str.length(), str.data(), str.length());
+	return true;
+}
+
+void FormatValue(char *dest, double val)
+{
+	//Same as %.8E, but without the C locale
+	char Buffer[32];
+	std::to_chars_result res = std::to_chars(Buffer, Buffer + sizeof(Buffer), val, std::chars_format::scientific, 8);
+	size_t len = res.ptr - Buffer;
+
+	for (size_t i = 0; i < len; i++)
+	{
+		if (Buffer[i] >= 'a' && Buffer[i] <= 'z') Buffer[i] -= 'a' - 'A';
+	}
+
+	//At most 16 characters, e.g. -1.23456789E+300, so it always fits
+	FixedWidthString(dest, std::string_view(Buffer, len), 17U);
+}
+
+void FormatInt(char *dest, int val)
+{
+	char Buffer[16];
+	std::to_chars_result res = std::to_chars(Buffer, Buffer + sizeof(Buffer), val);
+
+	//At most 11 characters
+	FixedWidthString(dest, std::string_view(Buffer, res.ptr - Buffer), 17U);
+}
+
+bool FormatID(char *dest, std::string_view ID, int Opp, int Card)
+{
+	//Year and day, then opportunity and card number like %01d%03d
+	char Buffer[64];
+	if (ID.length() > 12) return false;
+	memcpy(Buffer, ID.data(), ID.length());
+
+	char *p = std::to_chars(Buffer + ID.length(), Buffer + 32, Opp).ptr;
+	if (Card >= 0 && Card < 100)
+	{
+		*p++ = '0';
+		if (Card < 10) *p++ = '0';
+	}
+	p = std::to_chars(p, Buffer + sizeof(Buffer), Card).ptr;
+
+	return FixedWidthString(dest, std::string_view(Buffer, p - Buffer), 12U);
+}
@@ -0,0 +1,722 @@
+/***************************************************************************
+  This file is part of Project Apollo - NASSP
+  Copyright (c) 2022 Niklas Beug
+
+  RTCC TLI presettings converter
+
+  Project Apollo is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Project Apollo is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Project Apollo; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  See http://nassp.sourceforge.net/license/ for more details.
+
+  **************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+//Card layout. Every card has four fields of 17 columns, taken from the LVDC presettings in the scenario.
+
+//Content of a card field
+enum class FieldType
+{
+	Value,		//LVDC presetting
+	LaunchDay,	//Day in year of launch
+	Opp,		//Opportunity, 1 or 2
+};
+
+//Conversion of a LVDC presetting to RTCC units
+enum class FieldConv
+{
+	None,
+	DivHRS,				//s to hr
+	MulHRS,				//1/s to 1/hr
+	MulHRS2,			//1/s^2 to 1/hr^2
+	MulRAD,				//deg to rad
+	DivER2HR2,			//m^2/s^2 to er^2/hr^2
+	DivR_Earth,			//m to er
+	DivR_EarthMulHRS,	//m/s to er/hr
+	MulHRSDivR_Earth,	//m/s to er/hr
+	DivLBSMulHRS,		//kg/s to lbs/hr
+	GRRTime,			//Presetting has GRR time in s, RTCC needs liftoff time in hr
+	GRRAngle,			//Presetting has angle at GRR time, RTCC needs liftoff time. Earth rate is the field Ref.
+};
+
+//Name of a LVDC presetting, built at compile time
+struct LVDCKey
+{
+	char Str[24];
+	size_t Len;
+
+	constexpr std::string_view View() const { return std::string_view(Str, Len); }
+};
+
+//Key name with optional opportunity letter and index, e.g. LVDC_TPA13
+constexpr LVDCKey MakeKey(const char *str, char opp = 0, int num = -1)
+{
+	LVDCKey key{};
+
+	while (*str) key.Str[key.Len++] = *str++;
+	if (opp) key.Str[key.Len++] = opp;
+	if (num >= 10) key.Str[key.Len++] = (char)('0' + num / 10);
+	if (num >= 0) key.Str[key.Len++] = (char)('0' + num % 10);
+	return key;
+}
+
+struct FieldDesc
+{
+	FieldType Type;
+	LVDCKey Key;
+	double Default;
+	FieldConv Conv;
+	//Field with the second input of the conversion
+	int Ref;
+};
+
+struct CardDesc
+{
+	int Opp;
+	FieldDesc Field[4];
+};
+
+//Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	//Returns false if the file can't be opened
+	bool Open(const std::string &FileName);
+	void Close();
+	std::string_view Data() const { return std::string_view(Ptr, Size); }
+protected:
+	const char *Ptr;
+	size_t Size;
+#ifdef _WIN32
+	//File mapping handle, windows.h is only included by the library
+	void *hMapping;
+#endif
+};
+
+//Scenarios and manifests in a .gz, .zip or .tar.gz file, decompressed in memory without extracting them to disk.
+//Members of a zip or tar archive are named like files in a directory, e.g. Missions.zip/Apollo 11 - Launch.scn
+class ScenarioArchive
+{
+public:
+	//Returns false if the file can't be opened or isn't a gzip or zip file
+	bool Open(const std::string &FileName);
+	//Decompresses a member. A gzip file that isn't a tar archive has one member with an empty name.
+	//Returns false if there is no such member or the archive is damaged.
+	bool Extract(std::string_view Name, std::string &Data);
+	bool Extract(std::string_view Name, std::pmr::string &Data);
+	//Decompresses all members with names ending in Suffix, in archive order. Returns false if the archive is damaged.
+	bool ExtractAll(std::string_view Suffix, std::vector<std::pair<std::string, std::string>> &Members);
+	//False for a single gzip file
+	bool HasMembers() const { return Kind != ArchiveKind::Gzip; }
+
+	//Splits Missions.zip/Apollo 11.scn into the archive and member names. Returns false if no directory of the path is a .zip, .tar.gz or .tgz file.
+	static bool SplitPath(const std::string &Path, std::string &Archive, std::string &Member);
+	static bool IsGzip(std::string_view Data);
+	static bool IsZip(std::string_view Data);
+	//Decompresses a whole gzip file, returns false if it is damaged
+	static bool Gunzip(std::string_view In, std::string &Out);
+	static bool Gunzip(std::string_view In, std::pmr::string &Out);
+protected:
+	enum class ArchiveKind
+	{
+		Gzip,
+		Tar,	//Tar in gzip
+		Zip,
+	};
+
+	//Extract into a std::string or std::pmr::string, which keeps its allocator
+	template<class S> bool ExtractTo(std::string_view Name, S &Data);
+	//Decompresses each member that Wanted accepts into Contents, a std::string or std::pmr::string, and calls Found
+	//with it, until Found returns false. Returns false if the archive is damaged.
+	template<class S, class F> bool ReadMembers(const std::function<bool(std::string_view)> &Wanted, F Found, S &Contents);
+	template<class S, class F> bool ReadTar(const std::function<bool(std::string_view)> &Wanted, F Found, S &Contents);
+	template<class S, class F> bool ReadZip(const std::function<bool(std::string_view)> &Wanted, F Found, S &Contents);
+
+	MappedFile Map;
+	ArchiveKind Kind;
+};
+
+//LVDC presetting as found in a scenario
+struct ScenarioValue
+{
+	double Value;
+	//Position of the value in the file, for error messages
+	size_t Offset;
+	//False if the value isn't a number
+	bool Valid;
+};
+
+//Result of a presetting lookup
+enum class LookupStatus
+{
+	Found,		//Valid value in the scenario
+	Defaulted,	//Not in the scenario, the default value is used
+	Malformed,	//In the scenario, but not a number. The default value is used.
+};
+
+//Bulk scanning kernels for scenario files. Most of a scenario is vessel state and panel switches,
+//these skip over it to the LVDC presettings without looking at each line.
+struct LineScanner
+{
+	//Returns the next "LVDC_" in [p, end), or end
+	const char *(*FindKey)(const char *p, const char *end);
+	//Returns the number of line breaks in [p, end)
+	size_t (*CountLines)(const char *p, const char *end);
+	const char *Name;
+};
+
+//Fastest scanner the CPU supports, AVX2, SSE2 or scalar
+const LineScanner &GetLineScanner();
+
+//Counters and phase times of a run for --stats. Each scenario has its own, they are added up at the end.
+struct RunStats
+{
+	//Seconds per phase, added up over the threads
+	double Open = 0.0, Scan = 0.0, Lookup = 0.0, Convert = 0.0, Format = 0.0, Write = 0.0;
+	uint64_t Bytes = 0, Lines = 0, Keys = 0;
+	//Results of SearchForDouble
+	uint64_t Found = 0, Defaulted = 0, Malformed = 0;
+	uint64_t CacheHits = 0, CacheMisses = 0;
+	//Cards copied from an earlier launch day with the same presettings
+	uint64_t Interned = 0;
+	//Cards in the decks that were written
+	uint64_t Cards[3] = { 0, 0, 0 };
+	//Blocks the scenario arenas had to get from the heap, 0 once they have grown to the scenarios
+	uint64_t ArenaAllocs = 0;
+	unsigned Scenarios = 0, ScenariosFailed = 0, Decks = 0, DecksFailed = 0;
+
+	void Add(const RunStats &other);
+	//Report for dashboards, with the wall time of the run and the number of threads
+	std::string ToJSON(double Wall, unsigned Threads) const;
+};
+
+//Seconds since some fixed point, for the phase times
+double StatsClock();
+
+//Memory for everything that is parsed and rendered from one scenario. Allocations only move a pointer and Reset frees
+//all of them at once. The buffer is kept and grows to the largest scenario so far, up to MaxCapacity, so a reused arena
+//stops going to the heap.
+class ScenarioArena
+{
+public:
+	ScenarioArena(size_t Initial = 1 << 16);
+	~ScenarioArena();
+	ScenarioArena(const ScenarioArena &) = delete;
+	ScenarioArena &operator=(const ScenarioArena &) = delete;
+
+	std::pmr::memory_resource *Resource() { return &*Pool; }
+	//Frees everything. Nothing allocated from the arena may be used afterwards.
+	void Reset();
+
+	//Heap allocations and their bytes since construction, the buffer included
+	uint64_t HeapAllocs() const { return Heap.Allocs; }
+	uint64_t HeapBytes() const { return Heap.Bytes; }
+	size_t Capacity() const { return Size; }
+
+	//Largest buffer that is kept, bigger scenarios take the rest from the heap each time
+	static constexpr size_t MaxCapacity = 16 << 20;
+protected:
+	//Heap blocks with counters, for the buffer and for the monotonic resource when the buffer is full
+	class CountingResource : public std::pmr::memory_resource
+	{
+	public:
+		uint64_t Allocs = 0, Bytes = 0;
+		//Bytes taken since the last reset
+		size_t Used = 0;
+	protected:
+		void *do_allocate(size_t bytes, size_t align) override;
+		void do_deallocate(void *p, size_t bytes, size_t align) override;
+		bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+	};
+
+	CountingResource Heap;
+	void *Buffer;
+	size_t Size;
+	std::optional<std::pmr::monotonic_buffer_resource> Pool;
+};
+
+//Resets an arena when it goes out of scope. Declare it before the objects that use the arena.
+class ArenaScope
+{
+public:
+	explicit ArenaScope(ScenarioArena &arena) : Arena(arena) {}
+	~ArenaScope() { Arena.Reset(); }
+	ArenaScope(const ArenaScope &) = delete;
+	ArenaScope &operator=(const ArenaScope &) = delete;
+protected:
+	ScenarioArena &Arena;
+};
+
+//Key/value table of the LVDC presettings in a scenario, built with a single pass over the file.
+//The keys point into the mapped file, so no line is copied.
+class ScenarioIndex
+{
+public:
+	//The table and any decompressed or streamed text are allocated from Memory, e.g. a ScenarioArena
+	explicit ScenarioIndex(std::pmr::memory_resource *Memory = std::pmr::get_default_resource());
+
+	//Returns false if the file can't be opened. Gzip files and members of archives are decompressed in memory.
+	bool Load(const std::string &FileName, RunStats *stats = nullptr);
+	//Reads a scenario from a pipe in one forward pass, only the LVDC lines are kept.
+	//Returns false on a read error.
+	bool LoadStream(std::FILE *file, RunStats *stats = nullptr);
+	//Indexes a scenario in memory, which must outlive the index. Always returns true.
+	bool LoadBuffer(std::string_view Contents, RunStats *stats = nullptr);
+	//Indexes the contents of a file read elsewhere, e.g. by ScenarioReader, which must outlive the index. Gzip is decompressed.
+	//Returns false if it can't be decompressed.
+	bool LoadRead(std::string_view Contents, RunStats *stats = nullptr);
+	//Returns the first line of this key with a valid value, else its first line, or nullptr. Only the keys of the schema are kept.
+	const ScenarioValue *Find(std::string_view Key) const;
+	//Line and column of a value, both starting at 1
+	void Locate(const ScenarioValue &v, unsigned &Line, unsigned &Column) const;
+	//Hash of the schema presettings, the only part of a scenario the cards depend on
+	uint64_t ContentHash() const { return Hash; }
+	//Where the index allocates, for other scratch memory of the scenario
+	std::pmr::memory_resource *Memory() const { return Values.get_allocator().resource(); }
+
+	//Presetting with this schema index, or nullptr
+	const ScenarioValue *FindIndex(size_t Index) const { return Values[Index].Offset == NoOffset ? nullptr : &Values[Index]; }
+
+	//Position of a key in the schema, the LVDC presettings of the layout tables. -1 if it isn't one of them.
+	static int SchemaIndex(std::string_view Key);
+protected:
+	//Offset of a schema key that isn't in the scenario
+	static constexpr size_t NoOffset = (size_t)-1;
+
+	void Reset();
+	//Adds the presettings of the lines in text to the table, Base is the offset of text in Text.
+	//Stops when all schema keys have a valid value, the rest of a scenario can't change the cards then.
+	//Returns the number of bytes scanned.
+	size_t Index(std::string_view text, size_t Base);
+
+	MappedFile Map;
+	//Member of an archive, extracted by the archive reader
+	std::pmr::string Extracted;
+	//LVDC lines of a streamed scenario, with the offset and line number of each in the stream, or a decompressed scenario
+	std::pmr::string Kept;
+	std::pmr::vector<std::pair<size_t, unsigned>> KeptLines;
+	//Indexed text, the mapped file or the kept lines
+	std::string_view Text;
+	//Presettings by schema index
+	std::pmr::vector<ScenarioValue> Values;
+	//Schema keys with a valid value so far
+	size_t Resolved;
+	uint64_t Hash;
+};
+
+//Fixed set of worker threads for parallel loops
+class ThreadPool
+{
+public:
+	//0 threads means one per core
+	ThreadPool(unsigned Threads = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	//Calls func for 0 to count - 1 on all threads, returns when all calls are done
+	void Run(size_t count, const std::function<void(size_t)> &func);
+	//Threads including the caller
+	unsigned Size() const { return (unsigned)Workers.size() + 1; }
+	//Arena of the calling thread, for the scenario it works on in func. The caller of Run has the first one.
+	ScenarioArena &Arena();
+	//Heap allocations of the arenas of all threads, between calls of Run
+	uint64_t ArenaHeapAllocs() const;
+protected:
+	void Worker(size_t Index);
+	void RunItems();
+
+	std::vector<std::thread> Workers;
+	//One per thread, the caller first
+	std::vector<std::unique_ptr<ScenarioArena>> Arenas;
+	std::mutex Mutex;
+	std::condition_variable WakeUp, Done;
+	const std::function<void(size_t)> *Func;
+	size_t Count;
+	std::atomic<size_t> Next;
+	//Workers that haven't finished the current loop
+	unsigned Pending;
+	uint64_t Generation;
+	bool Quit;
+};
+
+//Reads many scenario files at once. On Linux the opens and reads of up to Depth files are in flight together through
+//io_uring. Each file goes to the parser on a thread of the pool as soon as it is read, while the other reads go on.
+//Without io_uring the files are loaded by the threads of the pool, as ScenarioIndex::Load does.
+class ScenarioReader
+{
+public:
+	//Calls Parse(i, Data) once for each file i, on the threads of the pool. Data is the contents of the file until Parse
+	//returns, the buffer is then reused for another file. It is nullptr if the file wasn't read ahead: stdin, archive
+	//members, files that can't be read and all files without io_uring. Parse then loads it with ScenarioIndex::Load,
+	//which also reports the errors.
+	static void Read(const std::vector<std::string> &Files, ThreadPool &pool, const std::function<void(size_t, const std::string *)> &Parse);
+	//"io_uring" if it can be used, otherwise "threads"
+	static const char *Backend();
+
+	//Files read at the same time
+	static constexpr unsigned Depth = 64;
+};
+
+LookupStatus SearchForDouble(const ScenarioIndex &file, std::string_view str, double &val, double defval);
+//Writes str right-justified into a field of len columns. Returns false and writes nothing if it is wider.
+bool FixedWidthString(char *dest, std::string_view str, unsigned len);
+//Writes a value in %.8E format into a field of 17 columns
+void FormatValue(char *dest, double val);
+//Writes an integer into a field of 17 columns
+void FormatInt(char *dest, int val);
+//Writes the 12 column card ID. Returns false and writes nothing if it is wider.
+bool FormatID(char *dest, std::string_view ID, int Opp, int Card);
+
+//One RTCC TLI parameters file and the scenarios it is made from
+struct DeckJob
+{
+	//Output file name
+	std::string FileNameOut;
+	//Year
+	int Year;
+	//Day in year array
+	std::vector<int> LaunchDayArr;
+	//Input file names of scenarios with LVDC data
+	std::vector<std::string> FileNameInArr;
+};
+
+//Launch day of a deck, the unit of parallel work. The file name is a copy, so a task doesn't depend on its DeckJob.
+struct DeckTask
+{
+	std::string FileName;
+	int LaunchDay;
+};
+
+//80 column card. The ID in columns 69 - 80 depends on the position of the card in the deck and is only filled in when it is written.
+struct CardRecord
+{
+	char Text[81];
+	int Opp;
+};
+
+//File name of stdin and stdout
+const std::string StdStream = "-";
+
+//Malformed presetting in a scenario
+struct ScenarioError
+{
+	std::string_view Key;
+	unsigned Line, Column;
+};
+
+//Cards of the three sections from one scenario
+struct ScenarioCards
+{
+	//False if the scenario can't be opened
+	bool Found;
+	std::vector<CardRecord> Section[3];
+	//Malformed presettings, the cards can't be used if there are any
+	std::vector<ScenarioError> Errors;
+};
+
+//LVDC presetting recovered from a card of a deck
+struct DeckValue
+{
+	double Value;
+	//Largest difference to the presetting that the 9 digits of the card can hide
+	double Tolerance;
+	//Card number and field the value was read from
+	int Card, Field;
+	const FieldDesc *Desc;
+};
+
+//Card of a deck, as read back
+struct DeckCard
+{
+	//Two digit year, launch day and opportunity from the card ID
+	int Year, LaunchDay, Opp;
+	int Card;
+	double Field[4];
+};
+
+//RTCC TLI deck read back into cards and LVDC presettings
+class TLIDeck
+{
+public:
+	//Returns false if the file can't be opened or isn't a deck. Error and ErrorLine say why.
+	bool Load(const std::string &FileName);
+	//Card with this number, or nullptr
+	const DeckCard *FindCard(int Card) const;
+	//Number of launch days in the deck
+	size_t Days() const { return Values.size(); }
+	int LaunchDay(size_t Day) const { return LaunchDayArr[Day]; }
+	const std::vector<DeckCard> &Cards() const { return CardArr; }
+	//All presettings of a launch day in card order. Some are on the cards of both opportunities.
+	const std::vector<DeckValue> &Presettings(size_t Day) const { return Values[Day]; }
+	//First card value of a presetting, or nullptr
+	const DeckValue *FindPresetting(size_t Day, std::string_view Key) const;
+
+	std::string Error;
+	unsigned ErrorLine;
+protected:
+	//Returns false with Error set
+	bool Fail(unsigned Line, const char *Msg);
+
+	std::vector<DeckCard> CardArr;
+	std::unordered_map<int, size_t> CardIndex;
+	std::vector<int> LaunchDayArr;
+	std::vector<std::vector<DeckValue>> Values;
+	std::vector<std::unordered_map<std::string_view, size_t>> ValueIndex;
+};
+
+//Cards of scenarios from earlier runs, keyed by the LVDC lines of the scenario and the launch day.
+//The card IDs aren't part of the cards, so the same entry serves every year and position in a deck.
+class CardCache
+{
+public:
+	CardCache();
+
+	//A missing or outdated cache file gives an empty cache
+	void Load(const std::string &FileName);
+	//Writes the cache back if it has changed. Entries that haven't been used for a while are dropped.
+	bool Save();
+	//Returns false if there are no cards for this key
+	bool Find(uint64_t Key, ScenarioCards &cards);
+	void Insert(uint64_t Key, const ScenarioCards &cards);
+
+	bool Enabled() const { return FileName.empty() == false; }
+
+	static uint64_t Key(uint64_t ContentHash, int LaunchDay);
+protected:
+	struct Entry
+	{
+		std::vector<CardRecord> Section[3];
+		//Run in which the entry was last used
+		uint32_t LastRun;
+	};
+
+	std::string FileName;
+	std::mutex Mutex;
+	std::unordered_map<uint64_t, Entry> Entries;
+	uint32_t Run;
+	bool Changed;
+};
+
+//Formatted fields of the cards rendered so far in a run. The launch days of a mission mostly have the same presettings
+//in sections 2 and 3, so those cards are only converted and formatted once and copied after that.
+class CardInterner
+{
+public:
+	CardInterner() : Entries(&Memory) {}
+
+	//Copies the fields of a card with the same layout and bit for bit the same presettings into Text.
+	//Returns false if there is none. LaunchDay only counts for cards that show it.
+	bool Find(const CardDesc &desc, const double raw[4], int LaunchDay, char *Text);
+	void Insert(const CardDesc &desc, const double raw[4], int LaunchDay, const char *Text);
+protected:
+	struct Entry
+	{
+		const CardDesc *Desc;
+		uint64_t Raw[4];
+		int LaunchDay;
+		//Columns 1 - 68, the card ID is filled in when the deck is written
+		char Text[68];
+	};
+
+	//Hash of the layout, presettings and launch day. Entries with the same hash are compared in full.
+	static uint64_t Key(const CardDesc &desc, const double raw[4], int LaunchDay, Entry &e);
+
+	std::mutex Mutex;
+	//The entries live as long as the interner, so they are taken from blocks that grow with the run
+	std::pmr::monotonic_buffer_resource Memory;
+	std::pmr::unordered_map<uint64_t, Entry> Entries;
+};
+
+//Presettings of a batch of launch days in structure of arrays form. There is a column for each schema key with a row
+//for each launch day, once as in the scenarios and once in RTCC units. The unit conversions are SIMD passes over the columns.
+class PresettingStore
+{
+public:
+	explicit PresettingStore(std::pmr::memory_resource *Memory = std::pmr::get_default_resource()) : RawCols(Memory), ConvCols(Memory) {}
+
+	//Room for Days launch days
+	void Reset(size_t Days);
+	//Copies the presettings of a scenario into the row of launch day Day. Missing and malformed ones get their defaults,
+	//the malformed ones are added to errors. Different days can be extracted on different threads.
+	void Extract(size_t Day, const ScenarioIndex &in, std::vector<ScenarioError> &errors, RunStats *stats = nullptr);
+	//Converts all rows to RTCC units, after all of them are extracted
+	void Convert(RunStats *stats = nullptr);
+	//Renders the cards of launch day Day from the converted columns. intern can be nullptr.
+	void Render(size_t Day, int LaunchDay, ScenarioCards &cards, CardInterner *intern = nullptr, RunStats *stats = nullptr) const;
+
+	size_t Days() const { return DayCount; }
+	//Presetting with schema index Key on a launch day, as in the scenario
+	double Raw(size_t Key, size_t Day) const { return RawCols[Key * Stride + Day]; }
+	//The same in RTCC units, valid after Convert
+	double Converted(size_t Key, size_t Day) const { return ConvCols[Key * Stride + Day]; }
+	//Presettings with schema index Key of all launch days
+	const double *RawColumn(size_t Key) const { return RawCols.data() + Key * Stride; }
+protected:
+	size_t DayCount = 0;
+	//Rows per column, rounded up to whole SIMD vectors
+	size_t Stride = 0;
+	std::pmr::vector<double> RawCols, ConvCols;
+};
+
+enum class RuleKind
+{
+	//Every presetting is a finite number
+	Finite,
+	//Key is within [Lo, Hi]
+	Range,
+	//Key is not greater than Key2
+	Order
+};
+
+//Plausibility check of the presettings, in scenario units
+struct PresettingRule
+{
+	RuleKind Kind;
+	//Schema indices, Key2 only for Order
+	int Key, Key2;
+	double Lo, Hi;
+};
+
+//A presetting of one launch day that breaks a rule
+struct PresettingViolation
+{
+	//Launch day row of the store
+	size_t Day;
+	const PresettingRule *Rule;
+	//Schema index and value of the presetting, Value2 is the one of Rule->Key2
+	int Key;
+	double Value, Value2;
+};
+
+//Checks all launch days of a store against the plausibility rules, one batched pass over the columns per rule. The
+//violations are appended sorted by launch day. Returns true if there are none.
+bool ValidatePresettings(const PresettingStore &store, std::vector<PresettingViolation> &Violations);
+//E.g. "LVDC_COSA3 is 1.2, outside [-1, 1]"
+std::string DescribeViolation(const PresettingViolation &v);
+//Screens the scenarios of all decks at once, each scenario once. No deck is written.
+bool ValidateDecks(const std::vector<DeckJob> &Jobs, ThreadPool &pool);
+
+//Card that differs between two decks
+struct CardChange
+{
+	//Card ID as on the card, e.g. 691971001
+	std::string ID;
+	//Card in the old and the new deck, empty if that deck doesn't have it
+	std::string Old, New;
+	//Bit f is set if field f differs
+	unsigned Fields;
+};
+
+//How GenerateDecks writes the decks
+struct DeckWriteOptions
+{
+	//The cards of the launch days of each job replace the same launch days in its existing deck, see PatchDeck
+	bool Patch = false;
+	//Each deck is also written as <output>.bin, see RTCC_TLI_BinaryDeck.h. Not for decks written to stdout.
+	bool Binary = false;
+};
+
+//stats can be nullptr
+bool GenerateDecks(const std::vector<DeckJob> &Jobs, ThreadPool &pool, CardCache &cache, RunStats *stats, const DeckWriteOptions &Write = DeckWriteOptions());
+//Compares two decks card by card, matched by card ID. The changes are in the order of the new deck, followed by the
+//cards that were removed. Returns false with Error set if a deck can't be read.
+bool DiffDecks(const std::string &OldFile, const std::string &NewFile, std::vector<CardChange> &Changes, std::string &Error);
+//Writes the cards of the launch days of job over these launch days in the existing deck job.FileNameOut. Only the IDs of
+//the launch days and of the replaced cards are read, and only the replaced cards are written. Nothing is written if a
+//launch day isn't in the deck. Returns false with Error set.
+bool PatchDeck(const DeckJob &job, const ScenarioCards *cards, std::string &Error);
+//Compares existing decks with the presettings in their scenarios
+bool VerifyDecks(const std::vector<DeckJob> &Jobs, ThreadPool &pool);
+//Records a malformed presetting once
+void AddError(std::vector<ScenarioError> &errors, const ScenarioIndex &file, std::string_view Key);
+//Loads and renders a scenario. The index and the presettings go into arena, which is reset when done; nullptr uses the heap.
+void ReadScenario(const std::string &FileName, int LaunchDay, ScenarioCards &cards, CardCache &cache, CardInterner *intern = nullptr, RunStats *stats = nullptr, ScenarioArena *arena = nullptr);
+//Makes the cards of a loaded scenario. intern can be nullptr.
+void RenderScenario(const ScenarioIndex &in, int LaunchDay, ScenarioCards &cards, CardCache &cache, CardInterner *intern = nullptr, RunStats *stats = nullptr);
+//Appends the text of a deck. Returns false with Error set if a card ID doesn't fit into its columns.
+bool WriteDeck(const DeckJob &job, const ScenarioCards *cards, std::string &out, std::string &Error);
+//The same cards as a binary deck, with the values read back from the card text
+bool WriteBinaryDeck(const DeckJob &job, const ScenarioCards *cards, std::string &out, std::string &Error);
+bool WriteFileAtomic(const std::string &FileName, const std::string &Data);
+//Writes a deck to a pipe
+bool WriteStream(std::FILE *file, const std::string &Data);
+bool ParseInt(const std::string &str, int &val);
+//Reads a manifest file, or the .manifest members of an archive. The scenarios of an archive manifest are in the archive.
+bool ReadManifest(const std::string &FileName, std::vector<DeckJob> &Jobs);
+//A deck has 1 to MaxDeckDays launch days, each a day of year from 1 to 366 and each only once.
+//Returns false with Error set otherwise.
+bool CheckLaunchDays(const std::vector<int> &LaunchDayArr, std::string &Error);
+//Unique LVDC keys of all layout tables, with their defaults
+void LayoutKeys(std::vector<const FieldDesc *> &Keys);
+
+//First card number of the three sections
+extern const int SectionFirstCard[3];
+//Launch days of a deck, with more the section 1 cards would run into the card numbers of section 2
+const int MaxDeckDays = 10;
+//Layout tables of the three sections, for code that picks the section at runtime
+extern const CardDesc *const SectionLayout[3];
+extern const size_t SectionSize[3];
+//Number of different LVDC presettings in the layout tables
+extern const size_t SchemaSize;
+
+//Scenario of one launch day for GenerateDeck
+struct ScenarioInput
+{
+	int LaunchDay;
+	//Scenario file, - for stdin. If empty, Contents is the scenario.
+	std::string FileName;
+	//Scenario text, must stay valid until GenerateDeck returns
+	std::string_view Contents;
+};
+
+//Deck made by GenerateDeck
+struct DeckOutput
+{
+	//Cards in deck order, with the card IDs filled in
+	std::vector<CardRecord> Cards;
+	//The deck as it would be written to a file
+	std::string Text;
+	//The same deck in the binary format of RTCC_TLI_BinaryDeck.h
+	std::string Binary;
+	//Why the deck couldn't be made
+	std::vector<std::string> Errors;
+};
+
+//Makes the deck of a year with a launch day per scenario, without writing any file. Returns false with Deck.Errors filled in
+//if a scenario can't be read or has malformed presettings. Calls from several threads at once are fine.
+bool GenerateDeck(int Year, const std::vector<ScenarioInput> &Scenarios, DeckOutput &Deck, RunStats *stats = nullptr);
@@ -22,830 +22,299 @@
 
   **************************************************************************/
 
+#include "RTCC_TLI_Presettings.h"
+
 #include <iostream>
-#include <fstream>
+#include <algorithm>
 #include <string>
 #include <vector>
 
-bool SearchForDoubleOpp(std::ifstream &file, const char *str, char opp, int num, double &val, double defval);
-bool SearchForDoubleOpp2(std::ifstream &file, const char *str, char opp, double &val, double defval);
-bool SearchForDouble(std::ifstream &file, const char *str, double &val, double defval);
-std::string FixedWidthString(std::string str, unsigned len);
-std::string FormatID(std::string ID, int Opp, int Card);
-
-void ReadSection1(const std::vector<std::string> &FileNameInArr, const std::vector<int> &LaunchDayArr, int Year, std::ofstream &out);
-void ReadSection2(const std::vector<std::string> &FileNameInArr, const std::vector<int> &LaunchDayArr, int Year, std::ofstream &out);
-void ReadSection3(const std::vector<std::string> &FileNameInArr, const std::vector<int> &LaunchDayArr, int Year, std::ofstream &out);
-
-const double R_Earth = 6378165.0;
-const double PI = 3.14159265358979323846;
-const double RAD = PI / 180.0;
-const double HRS = 3600.0;
-const double ER2HR2ToM2SEC2 = pow(R_Earth / 3600.0, 2);
-const double LBS = 0.45359237;
-const double DT_GRR = 17.0;
-
-int main()
+
+//Command line options besides the decks
+struct RunOptions
 {
-	//Input file name
-	std::string FileNameIn;
-	//Output file name of RTCC TLI parameters file, goes into \Config\ProjectApollo\RTCC
+	//Worker threads, 0 = one per core
+	unsigned Threads = 0;
+	//Compare the decks with the scenarios instead of writing them
+	bool Verify = false;
+	//Check the presettings of the scenarios against the plausibility rules instead of writing decks
+	bool Validate = false;
+	//How the decks are written
+	DeckWriteOptions Write;
+	//Decks to compare instead of generating any, empty for none
+	std::string DiffOld, DiffNew;
+	//Card cache file, empty for none
+	std::string CacheFile;
+	//JSON report of the run, empty for none
+	std::string StatsFile;
+};
+
+void PrintUsage();
+bool ParseCommandLine(int argc, char *argv[], std::vector<DeckJob> &Jobs, RunOptions &Options);
+//Prints the differences of the two decks of a diff, returns the exit code
+int PrintDiff(const RunOptions &Options);
+
+
+int main(int argc, char *argv[])
+{
+	//RTCC TLI parameters files to generate. Each goes into \Config\ProjectApollo\RTCC
 	//Contains punch card format from MSC internal note 69-FM-171
 	//https://web.archive.org/web/20100524010957/http://ntrs.nasa.gov/archive/nasa/casi.ntrs.nasa.gov/19740072570_1974072570.pdf
-	std::string FileNameOut;
-	//Year
-	int Year;
-	//Day
-	int LaunchDay;
-	//Day in year array
-	std::vector<int> LaunchDayArr;
-	//Input file names of scenarios with LVDC data
-	std::vector<std::string> FileNameInArr;
-
-	//Read in file name
-	std::cout << "Scenario file name:" << std::endl;
-	std::cin >> FileNameIn;
-	//Read in launch year
-	std::cout << "Year of launch:" << std::endl;
-	std::cin >> Year;
-	//Read in launch day
-	std::cout << "Day in year of launch:" << std::endl;
-	std::cin >> LaunchDay;
-	//Read in output file
-	std::cout << "Output file name:" << std::endl;
-	std::cin.ignore();
-	std::getline(std::cin, FileNameOut);
-
-	//Populate vectors
-	LaunchDayArr.push_back(LaunchDay);
-	FileNameInArr.push_back(FileNameIn);
-
-	/*
-	//INPUT PARAMETERS:
-	int ApolloNo = 0; // 0 = Custom
-
-	if (ApolloNo == 0)
-	{
-		LaunchDayArr.push_back(257);
-		Year = 1977;
-		FileNameInArr.push_back("Custom.txt");
-		snprintf(FileNameOut, 127, "Custom TLI.txt");
-	}
-	else if (ApolloNo == 3)
-	{
-		LaunchDayArr.push_back(15);
-		Year = 1969;
-		FileNameInArr.push_back("Apollo 3 - Launch.scn");
-		snprintf(FileNameOut, 127, "Apollo 3 TLI.txt");
-	}
-	else if (ApolloNo == 8)
-	{
-		LaunchDayArr.push_back(356);
-		Year = 1968;
-		FileNameInArr.push_back("Apollo 8 - Launch.scn");
-		snprintf(FileNameOut, 127, "Apollo 8 TLI.txt");
-	}
-	else if (ApolloNo == 9)
-	{
-		LaunchDayArr.push_back(62);
-		Year = 1969;
-		FileNameInArr.push_back("Apollo 9 - Launch.scn");
-		snprintf(FileNameOut, 127, "Apollo 9 TLI.txt");
-	}
-	else if (ApolloNo == 10)
-	{
-		LaunchDayArr.push_back(138);
-		Year = 1969;
-		FileNameInArr.push_back("Apollo 10 - Launch.scn");
-		snprintf(FileNameOut, 127, "Apollo 10 TLI.txt");
-	}
-	else if (ApolloNo == 11)
-	{
-		LaunchDayArr.push_back(197); FileNameInArr.push_back("Apollo 11 - Launch.scn");
-		LaunchDayArr.push_back(199); FileNameInArr.push_back("Apollo 11 - July 18th Launch.scn");
-		LaunchDayArr.push_back(202); FileNameInArr.push_back("Apollo 11 - July 21st Launch.scn");
-		snprintf(FileNameOut, 127, "Apollo 11 TLI.txt");
-		Year = 1969;
-	}
-	else if (ApolloNo == 12)
-	{
-		LaunchDayArr.push_back(318);
-		Year = 1969;
-		FileNameInArr.push_back("Apollo 12 - Launch.scn");
-		snprintf(FileNameOut, 127, "Apollo 12 TLI.txt");
-	}
-	else if (ApolloNo == 13)
-	{
-		LaunchDayArr.push_back(101);
-		Year = 1970;
-		FileNameInArr.push_back("Apollo 13 - Launch.scn");
-		snprintf(FileNameOut, 127, "Apollo 13 TLI.txt");
-	}
-	else if (ApolloNo == 14)
+	std::vector<DeckJob> Jobs;
+	RunOptions Options;
+	CardCache cache;
+	bool ok;
+
+	if (argc > 1)
 	{
-		LaunchDayArr.push_back(31);
-		Year = 1971;
-		FileNameInArr.push_back("Apollo 14 - Launch.scn");
-		snprintf(FileNameOut, 127, "Apollo 14 TLI.txt");
+		//Batch mode
+		if (ParseCommandLine(argc, argv, Jobs, Options) == false)
+		{
+			PrintUsage();
+			return 2;
+		}
+		if (Options.DiffOld.empty() == false) return PrintDiff(Options);
 	}
-	else if (ApolloNo == 15)
+	else
 	{
-		LaunchDayArr.push_back(207);
-		Year = 1971;
-		FileNameInArr.push_back("Apollo 15 - Launch.scn");
-		snprintf(FileNameOut, 127, "Apollo 15 TLI.txt");
+		DeckJob job;
+		//Input file name
+		std::string FileNameIn;
+		//Day
+		int LaunchDay;
+
+		//Read in file name
+		std::cout << "Scenario file name:" << std::endl;
+		std::cin >> FileNameIn;
+		//Read in launch year
+		std::cout << "Year of launch:" << std::endl;
+		std::cin >> job.Year;
+		//Read in launch day
+		std::cout << "Day in year of launch:" << std::endl;
+		std::cin >> LaunchDay;
+		//Read in output file
+		std::cout << "Output file name:" << std::endl;
+		std::cin.ignore();
+		std::getline(std::cin, job.FileNameOut);
+
+		//Populate vectors
+		job.LaunchDayArr.push_back(LaunchDay);
+		job.FileNameInArr.push_back(FileNameIn);
+
+		std::string Error;
+		if (CheckLaunchDays(job.LaunchDayArr, Error) == false)
+		{
+			std::cout << "Deck " << job.FileNameOut << " " << Error << std::endl;
+			return 2;
+		}
+		Jobs.push_back(job);
 	}
-	else if (ApolloNo == 16)
+
+	//stdin can only be read once
+	int StdinCount = 0;
+	for (size_t j = 0; j < Jobs.size(); j++)
 	{
-		LaunchDayArr.push_back(107);
-		Year = 1972;
-		FileNameInArr.push_back("Apollo 16 - Launch.scn");
-		snprintf(FileNameOut, 127, "Apollo 16 TLI.txt");
+		StdinCount += (int)std::count(Jobs[j].FileNameInArr.begin(), Jobs[j].FileNameInArr.end(), StdStream);
 	}
-	else if (ApolloNo == 17)
+	if (StdinCount > 1)
 	{
-		LaunchDayArr.push_back(342);
-		Year = 1972;
-		FileNameInArr.push_back("Apollo 17 - Launch.scn");
-		snprintf(FileNameOut, 127, "Apollo 17 TLI.txt");
+		std::cout << "Only one scenario can be read from stdin!" << std::endl;
+		return 2;
 	}
-	else return 0;
-	*/
-
-	std::ofstream out;
-
-	out.open(FileNameOut);
-	
-	//Read first section
-	ReadSection1(FileNameInArr, LaunchDayArr, Year, out);
-	//Read second section
-	ReadSection2(FileNameInArr, LaunchDayArr, Year, out);
-	//Read third section
-	ReadSection3(FileNameInArr, LaunchDayArr, Year, out);
 
-	out.close();
+	ThreadPool pool(Options.Threads);
 
-	std::cout << "File " << FileNameOut << " generated!" << std::endl;
-	return 0;
-}
-
-void ReadSection1(const std::vector<std::string> &FileNameInArr, const std::vector<int> &LaunchDayArr, int Year, std::ofstream &out)
-{
-	//Cards 1 - 460
+	if (Options.Verify) return VerifyDecks(Jobs, pool) ? 0 : 1;
+	if (Options.Validate) return ValidateDecks(Jobs, pool) ? 0 : 1;
 
-	std::ifstream in;
-	std::string tempstr, columns[5], card, ID;
-	char Buffer[128];
-	char OppChar;
-	double val1, val2, val3, val4;
-	int cardnum, opp, LaunchDay;
-	unsigned i, j, k;
+	RunStats stats;
+	RunStats *pstats = Options.StatsFile.empty() ? nullptr : &stats;
+	double start = StatsClock();
 
-	cardnum = 1;
+	if (Options.CacheFile.empty() == false) cache.Load(Options.CacheFile);
+	ok = GenerateDecks(Jobs, pool, cache, pstats, Options.Write);
+	//A cache that can't be written only costs time in the next run
+	if (cache.Save() == false)
+	{
+		std::cout << "File " << Options.CacheFile << " can't be written!" << std::endl;
+	}
 
-	for (i = 0; i < FileNameInArr.size(); i++)
+	if (pstats)
 	{
-		in.open(FileNameInArr[i]);
-		if (in.is_open() == false)
+		std::string report = stats.ToJSON(StatsClock() - start, pool.Size());
+		if ((Options.StatsFile == StdStream ? WriteStream(stdout, report) : WriteFileAtomic(Options.StatsFile, report)) == false)
 		{
-			std::cout << "File " << FileNameInArr[i] << " not found!" << std::endl;
-			continue;
+			std::cout << "File " << Options.StatsFile << " can't be written!" << std::endl;
+			ok = false;
 		}
-		std::cout << "Process file " << FileNameInArr[i] << std::endl;
-
-		LaunchDay = LaunchDayArr[i];
-
-		//Set up ID
-		snprintf(Buffer, 17, "%02d%03d", Year % 100, LaunchDay);
-		ID.assign(Buffer);
-
-		opp = 1;
-		OppChar = 'A';
-
-		for (j = 0; j < 2; j++)
-		{
-			//Card 1, 24
-			SearchForDoubleOpp(in, "LVDC_TP", OppChar, 0, val3, -1.0);
-			SearchForDoubleOpp(in, "LVDC_COS", OppChar, 0, val4, -1.0);
-
-			tempstr = std::to_string(LaunchDay);
-			columns[0] = FixedWidthString(tempstr, 17U);
-
-			tempstr = std::to_string(opp);
-			columns[1] = FixedWidthString(tempstr, 17U);
-
-			snprintf(Buffer, 17, "%.8E", val3 / HRS);
-			tempstr.assign(Buffer);
-			columns[2] = FixedWidthString(tempstr, 17U);
-
-			snprintf(Buffer, 17, "%.8E", val4);
-			tempstr.assign(Buffer);
-			columns[3] = FixedWidthString(tempstr, 17U);
-
-			columns[4] = FormatID(ID, opp, cardnum);
-
-			card = columns[0] + columns[1] + columns[2] + columns[3] + columns[4];
-			out << card << std::endl;
-			cardnum++;
-
-			//Card 2, 25
-			SearchForDoubleOpp(in, "LVDC_C3", OppChar, 0, val1, -1.0);
-			SearchForDoubleOpp(in, "LVDC_EN", OppChar, 0, val2, -1.0);
-			SearchForDoubleOpp(in, "LVDC_RAS", OppChar, 0, val3, -1.0);
-			SearchForDoubleOpp(in, "LVDC_DEC", OppChar, 0, val4, -1.0);
-
-			snprintf(Buffer, 17, "%.8E", val1 / ER2HR2ToM2SEC2);
-			tempstr.assign(Buffer);
-			columns[0] = FixedWidthString(tempstr, 17U);
-
-			snprintf(Buffer, 17, "%.8E", val2);
-			tempstr.assign(Buffer);
-			columns[1] = FixedWidthString(tempstr, 17U);
-
-			snprintf(Buffer, 17, "%.8E", val3 * RAD);
-			tempstr.assign(Buffer);
-			columns[2] = FixedWidthString(tempstr, 17U);
-
-			snprintf(Buffer, 17, "%.8E", val4 * RAD);
-			tempstr.assign(Buffer);
-			columns[3] = FixedWidthString(tempstr, 17U);
-
-			columns[4] = FormatID(ID, opp, cardnum);
-
-			card = columns[0] + columns[1] + columns[2] + columns[3] + columns[4];
-			out << card << std::endl;
-			cardnum++;
-
-			for (k = 0; k < 7; k++)
-			{
-				//Card 3, 6...
-				SearchForDoubleOpp(in, "LVDC_TP", OppChar, 2 * k + 1, val1, 1000.0);
-				SearchForDoubleOpp(in, "LVDC_COS", OppChar, 2 * k + 1, val2, 9.958662e-1);
-				SearchForDoubleOpp(in, "LVDC_C3", OppChar, 2 * k + 1, val3, -1.418676e6);
-				SearchForDoubleOpp(in, "LVDC_EN", OppChar, 2 * k + 1, val4, 0.9765500);
-
-				snprintf(Buffer, 17, "%.8E", val1 / HRS);
-				tempstr.assign(Buffer);
-				columns[0] = FixedWidthString(tempstr, 17U);
-
-				snprintf(Buffer, 17, "%.8E", val2);
-				tempstr.assign(Buffer);
-				columns[1] = FixedWidthString(tempstr, 17U);
-
-				snprintf(Buffer, 17, "%.8E", val3 / ER2HR2ToM2SEC2);
-				tempstr.assign(Buffer);
-				columns[2] = FixedWidthString(tempstr, 17U);
-
-				snprintf(Buffer, 17, "%.8E", val4);
-				tempstr.assign(Buffer);
-				columns[3] = FixedWidthString(tempstr, 17U);
-
-				columns[4] = FormatID(ID, opp, cardnum);
-
-				card = columns[0] + columns[1] + columns[2] + columns[3] + columns[4];
-				out << card << std::endl;
-				cardnum++;
-
-				//Card 4, 7...
-				SearchForDoubleOpp(in, "LVDC_RAS", OppChar, 2 * k + 1, val1, -114.382494);
-				SearchForDoubleOpp(in, "LVDC_DEC", OppChar, 2 * k + 1, val2, -26.646912);
-				SearchForDoubleOpp(in, "LVDC_TP", OppChar, 2 * k + 2, val3, 1000.0);
-				SearchForDoubleOpp(in, "LVDC_COS", OppChar, 2 * k + 2, val4, 9.958662e-1);
-
-
-				snprintf(Buffer, 17, "%.8E", val1 * RAD);
-				tempstr.assign(Buffer);
-				columns[0] = FixedWidthString(tempstr, 17U);
-
-				snprintf(Buffer, 17, "%.8E", val2 * RAD);
-				tempstr.assign(Buffer);
-				columns[1] = FixedWidthString(tempstr, 17U);
-
-				snprintf(Buffer, 17, "%.8E", val3 / HRS);
-				tempstr.assign(Buffer);
-				columns[2] = FixedWidthString(tempstr, 17U);
-
-				snprintf(Buffer, 17, "%.8E", val4);
-				tempstr.assign(Buffer);
-				columns[3] = FixedWidthString(tempstr, 17U);
-
-				columns[4] = FormatID(ID, opp, cardnum);
-
-				card = columns[0] + columns[1] + columns[2] + columns[3] + columns[4];
-				out << card << std::endl;
-				cardnum++;
-
-				//Card 5, 8...
-				SearchForDoubleOpp(in, "LVDC_C3", OppChar, 2 * k + 2, val1, -1.418676e6);
-				SearchForDoubleOpp(in, "LVDC_EN", OppChar, 2 * k + 2, val2, 0.9765500);
-				SearchForDoubleOpp(in, "LVDC_RAS", OppChar, 2 * k + 2, val3, -114.382494);
-				SearchForDoubleOpp(in, "LVDC_DEC", OppChar, 2 * k + 2, val4, -26.646912);
-
-				snprintf(Buffer, 17, "%.8E", val1 / ER2HR2ToM2SEC2);
-				tempstr.assign(Buffer);
-				columns[0] = FixedWidthString(tempstr, 17U);
-
-				snprintf(Buffer, 17, "%.8E", val2);
-				tempstr.assign(Buffer);
-				columns[1] = FixedWidthString(tempstr, 17U);
-
-				snprintf(Buffer, 17, "%.8E", val3 * RAD);
-				tempstr.assign(Buffer);
-				columns[2] = FixedWidthString(tempstr, 17U);
-
-				snprintf(Buffer, 17, "%.8E", val4 * RAD);
-				tempstr.assign(Buffer);
-				columns[3] = FixedWidthString(tempstr, 17U);
-
-				columns[4] = FormatID(ID, opp, cardnum);
-
-				card = columns[0] + columns[1] + columns[2] + columns[3] + columns[4];
-				out << card << std::endl;
-				cardnum++;
-			}
-
-			opp = 2;
-			OppChar = 'B';
-		}
-	
-		in.close();
 	}
+	return ok ? 0 : 1;
 }
 
-void ReadSection2(const std::vector<std::string> &FileNameInArr, const std::vector<int> &LaunchDayArr, int Year, std::ofstream &out)
-{
-	//Cards 460 - 540
 
-	std::ifstream in;
-	std::string tempstr, columns[5], card, ID;
-	char Buffer[128];
-	char OppChar;
-	double val1, val2, val3, val4;
-	int cardnum, opp, LaunchDay;
-	unsigned i, j;
+void PrintUsage()
+{
+	std::cout << "Usage:" << std::endl;
+	std::cout << "  RTCC_TLI_Presettings_Card_Format" << std::endl;
+	std::cout << "      Interactive, asks for one scenario" << std::endl;
+	std::cout << "  RTCC_TLI_Presettings_Card_Format -y <year> -o <output> <day> <scenario> [<day> <scenario> ...]" << std::endl;
+	std::cout << "      One deck with a launch day per scenario" << std::endl;
+	std::cout << "  RTCC_TLI_Presettings_Card_Format -m <manifest> [-m <manifest> ...]" << std::endl;
+	std::cout << "      All decks listed in the manifest files" << std::endl;
+	std::cout << "  RTCC_TLI_Presettings_Card_Format --diff <old deck> <new deck>" << std::endl;
+	std::cout << "      Cards and fields that differ between two decks, matched by card ID" << std::endl;
+	std::cout << "Options:" << std::endl;
+	std::cout << "  -j <threads>  Number of worker threads, default is one per core" << std::endl;
+	std::cout << "  -c <cache>    Reuse the cards of unchanged scenarios from this cache file" << std::endl;
+	std::cout << "  --stats <file> Write counters and phase times of the run as JSON" << std::endl;
+	std::cout << "  --verify      Check existing decks against their scenarios instead of writing them" << std::endl;
+	std::cout << "  --validate    Check the presettings of the scenarios for plausibility instead of writing decks" << std::endl;
+	std::cout << "  --patch       Replace the cards of the given launch days in the existing decks" << std::endl;
+	std::cout << "  --binary      Also write each deck as <output>.bin, with fixed size records for mapping" << std::endl;
+	std::cout << "A scenario named - is read from stdin, an output named - is written to stdout." << std::endl;
+}
 
-	cardnum = 461;
+bool ParseCommandLine(int argc, char *argv[], std::vector<DeckJob> &Jobs, RunOptions &Options)
+{
+	DeckJob job;
+	bool HaveYear = false, HaveDeck = false;
+	std::string arg;
+	int day;
 
-	for (i = 0; i < FileNameInArr.size(); i++)
+	for (int i = 1; i < argc; i++)
 	{
-		in.open(FileNameInArr[i]);
-		if (in.is_open() == false) continue;
-
-		LaunchDay = LaunchDayArr[i];
+		arg = argv[i];
 
-		//Set up ID
-		snprintf(Buffer, 17, "%02d%03d", Year % 100, LaunchDay);
-		ID.assign(Buffer);
-
-		opp = 1;
-		OppChar = 'A';
-
-		for (j = 0; j < 2; j++)
+		if (arg == "-m" || arg == "--manifest")
 		{
-			//Card 461, 465
-			SearchForDoubleOpp2(in, "LVDC_TST", OppChar, val3, 15000.0);
-			SearchForDoubleOpp2(in, "LVDC_BETA", OppChar, val4, 61.89975);
-
-
-			tempstr = std::to_string(LaunchDay);
-			columns[0] = FixedWidthString(tempstr, 17U);
-
-			tempstr = std::to_string(opp);
-			columns[1] = FixedWidthString(tempstr, 17U);
-
-			snprintf(Buffer, 17, "%.8E", val3 / HRS);
-			tempstr.assign(Buffer);
-			columns[2] = FixedWidthString(tempstr, 17U);
-
-			snprintf(Buffer, 17, "%.8E", val4*RAD);
-			tempstr.assign(Buffer);
-			columns[3] = FixedWidthString(tempstr, 17U);
-
-			columns[4] = FormatID(ID, opp, cardnum);
-
-			card = columns[0] + columns[1] + columns[2] + columns[3] + columns[4];
-			out << card << std::endl;
-			cardnum++;
-
-			//Card 462, 466
-			SearchForDoubleOpp2(in, "LVDC_ALFTS", OppChar, val1, 14.2691472);
-			SearchForDoubleOpp2(in, "LVDC_F", OppChar, val2, 14.26968);
-			SearchForDoubleOpp2(in, "LVDC_RN", OppChar, val3, 6575100.0);
-			SearchForDoubleOpp2(in, "LVDC_T3PR", OppChar, val4, 310.8243);
-
-			snprintf(Buffer, 17, "%.8E", val1* RAD);
-			tempstr.assign(Buffer);
-			columns[0] = FixedWidthString(tempstr, 17U);
-
-			snprintf(Buffer, 17, "%.8E", val2* RAD);
-			tempstr.assign(Buffer);
-			columns[1] = FixedWidthString(tempstr, 17U);
-
-			snprintf(Buffer, 17, "%.8E", val3 / R_Earth);
-			tempstr.assign(Buffer);
-			columns[2] = FixedWidthString(tempstr, 17U);
-
-			snprintf(Buffer, 17, "%.8E", val4 / HRS);
-			tempstr.assign(Buffer);
-			columns[3] = FixedWidthString(tempstr, 17U);
-
-			columns[4] = FormatID(ID, opp, cardnum);
-
-			card = columns[0] + columns[1] + columns[2] + columns[3] + columns[4];
-			out << card << std::endl;
-			cardnum++;
-
-			//Card 463, 467
-			if (opp == 1)
-			{
-				SearchForDoubleOpp2(in, "LVDC_TAU3R", OppChar, val1, 684.5038);
-			}
-			else
-			{
-				SearchForDoubleOpp2(in, "LVDC_TAU3R", OppChar, val1, 682.1127);
-			}
-			if (opp == 1)
-			{
-				SearchForDouble(in, "LVDC_T2IR", val2, 10.0);
-			}
-			else
-			{
-				SearchForDoubleOpp2(in, "LVDC_T2IR", OppChar, val2, 10.0);
-			}
-
-			SearchForDouble(in, "LVDC_V_ex2R", val3, 4221.827032);
-			SearchForDouble(in, "LVDC_dotM_2R", val4, 215.2241);
-
-
-			snprintf(Buffer, 17, "%.8E", val1 / HRS);
-			tempstr.assign(Buffer);
-			columns[0] = FixedWidthString(tempstr, 17U);
-
-			snprintf(Buffer, 17, "%.8E", val2 / HRS);
-			tempstr.assign(Buffer);
-			columns[1] = FixedWidthString(tempstr, 17U);
-
-			snprintf(Buffer, 17, "%.8E", val3 / R_Earth * 3600.0);
-			tempstr.assign(Buffer);
-			columns[2] = FixedWidthString(tempstr, 17U);
-
-			snprintf(Buffer, 17, "%.8E", val4 / LBS * HRS);
-			tempstr.assign(Buffer);
-			columns[3] = FixedWidthString(tempstr, 17U);
-
-			columns[4] = FormatID(ID, opp, cardnum);
-
-			card = columns[0] + columns[1] + columns[2] + columns[3] + columns[4];
-			out << card << std::endl;
-			cardnum++;
-
-			//Card 464, 468
-			SearchForDoubleOpp2(in, "LVDC_DVBR", OppChar, val1, 3.7);
-			SearchForDouble(in, "LVDC_tau2N", val2, 721.0);
-			SearchForDouble(in, "LVDC_K_P1", val3, 0.0);
-			SearchForDouble(in, "LVDC_K_Y1", val4, 0.0);
-
-			snprintf(Buffer, 17, "%.8E", val1* HRS / R_Earth);
-			tempstr.assign(Buffer);
-			columns[0] = FixedWidthString(tempstr, 17U);
-
-			snprintf(Buffer, 17, "%.8E", val2 / HRS);
-
-			tempstr.assign(Buffer);
-			columns[1] = FixedWidthString(tempstr, 17U);
-
-			snprintf(Buffer, 17, "%.8E", val3);
-			tempstr.assign(Buffer);
-			columns[2] = FixedWidthString(tempstr, 17U);
-
-			snprintf(Buffer, 17, "%.8E", val4);
-			tempstr.assign(Buffer);
-			columns[3] = FixedWidthString(tempstr, 17U);
-
-			columns[4] = FormatID(ID, opp, cardnum);
-
-			card = columns[0] + columns[1] + columns[2] + columns[3] + columns[4];
-			out << card << std::endl;
-			cardnum++;
-
-			opp = 2;
-			OppChar = 'B';
+			if (++i >= argc) return false;
+			if (ReadManifest(argv[i], Jobs) == false) return false;
+		}
+		else if (arg == "-y" || arg == "--year")
+		{
+			if (++i >= argc || ParseInt(argv[i], job.Year) == false) return false;
+			HaveYear = true;
+		}
+		else if (arg == "-j" || arg == "--threads")
+		{
+			int num;
+			if (++i >= argc || ParseInt(argv[i], num) == false || num < 0) return false;
+			Options.Threads = (unsigned)num;
+		}
+		else if (arg == "--verify")
+		{
+			Options.Verify = true;
+		}
+		else if (arg == "--validate")
+		{
+			Options.Validate = true;
+		}
+		else if (arg == "--patch")
+		{
+			Options.Write.Patch = true;
+		}
+		else if (arg == "--binary")
+		{
+			Options.Write.Binary = true;
+		}
+		else if (arg == "--diff")
+		{
+			if (i + 2 >= argc) return false;
+			Options.DiffOld = argv[++i];
+			Options.DiffNew = argv[++i];
+		}
+		else if (arg == "-c" || arg == "--cache")
+		{
+			if (++i >= argc) return false;
+			Options.CacheFile = argv[i];
+		}
+		else if (arg == "--stats")
+		{
+			if (++i >= argc) return false;
+			Options.StatsFile = argv[i];
+		}
+		else if (arg == "-o" || arg == "--output")
+		{
+			if (++i >= argc) return false;
+			job.FileNameOut = argv[i];
+			HaveDeck = true;
+		}
+		else
+		{
+			//Launch day and scenario pair
+			if (i + 1 >= argc || ParseInt(arg, day) == false) return false;
+			job.LaunchDayArr.push_back(day);
+			job.FileNameInArr.push_back(argv[++i]);
 		}
-
-		in.close();
 	}
-}
 
-void ReadSection3(const std::vector<std::string> &FileNameInArr, const std::vector<int> &LaunchDayArr, int Year, std::ofstream &out)
-{
-	//Cards 541 - 620
-
-	std::ifstream in;
-	std::string tempstr, columns[5], card, ID;
-	char Buffer[128];
-	double val1, val2, val3, val4;
-	int cardnum, LaunchDay, opp;
-	unsigned i;
+	if ((int)Options.Verify + (int)Options.Validate + (int)Options.Write.Patch > 1) return false;
+	//A patched deck would need its binary deck patched as well
+	if (Options.Write.Patch && Options.Write.Binary) return false;
+	//The cache is for runs that write whole decks, not for checks, diffs and patches
+	if (Options.CacheFile.empty() == false && (Options.Verify || Options.Validate || Options.Write.Patch || Options.DiffOld.empty() == false)) return false;
+	//Nothing else goes with a diff
+	if (Options.DiffOld.empty() == false) return Jobs.empty() && HaveYear == false && HaveDeck == false && job.FileNameInArr.empty() && Options.Verify == false && Options.Validate == false && Options.Write.Patch == false;
 
-	cardnum = 541;
-	opp = 2; //This section is actually opportunity independent
-
-	for (i = 0; i < FileNameInArr.size(); i++)
+	if (HaveDeck)
 	{
-		in.open(FileNameInArr[i]);
-		if (in.is_open() == false) continue;
-
-		LaunchDay = LaunchDayArr[i];
-
-		//Set up ID
-		snprintf(Buffer, 17, "%02d%03d", Year % 100, LaunchDay);
-		ID.assign(Buffer);
-
-		//Card 541
-		SearchForDouble(in, "LVDC_T_LO", val2, 0.0);
-		SearchForDouble(in, "LVDC_THTEO", val3, 0.0);
-		SearchForDouble(in, "LVDC_omega_E", val4, 7.292107788e-5);
-
-
-		tempstr = std::to_string(LaunchDay);
-		columns[0] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", (val2 + DT_GRR) / HRS); //Presetting has GRR time, RTCC needs liftoff time
-		tempstr.assign(Buffer);
-		columns[1] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val3 + DT_GRR * val4); //Presetting has angle at GRR time, RTCC needs liftoff time
-		tempstr.assign(Buffer);
-		columns[2] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val4*HRS);
-		tempstr.assign(Buffer);
-		columns[3] = FixedWidthString(tempstr, 17U);
-
-		columns[4] = FormatID(ID, opp, cardnum);
-
-		card = columns[0] + columns[1] + columns[2] + columns[3] + columns[4];
-		out << card << std::endl;
-		cardnum++;
-
-		//Card 542
-		SearchForDouble(in, "LVDC_K_a1", val1, 0.0);
-		SearchForDouble(in, "LVDC_K_a2", val2, 0.0);
-		SearchForDouble(in, "LVDC_K_T3", val3, -.274);
-		SearchForDouble(in, "LVDC_t_DS0", val4, 0.0);
-
-		snprintf(Buffer, 17, "%.8E", val1*HRS);
-		tempstr.assign(Buffer);
-		columns[0] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val2*pow(HRS, 2));
-		tempstr.assign(Buffer);
-		columns[1] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val3);
-		tempstr.assign(Buffer);
-		columns[2] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val4*HRS);
-		tempstr.assign(Buffer);
-		columns[3] = FixedWidthString(tempstr, 17U);
-
-		columns[4] = FormatID(ID, opp, cardnum);
-
-		card = columns[0] + columns[1] + columns[2] + columns[3] + columns[4];
-		out << card << std::endl;
-		cardnum++;
-
-		//Card 543
-		SearchForDouble(in, "LVDC_t_DS1", val1, 10984.2);
-		SearchForDouble(in, "LVDC_t_DS2", val2, 16503.1);
-		SearchForDouble(in, "LVDC_t_DS3", val3, 0.0);
-		SearchForDouble(in, "LVDC_hx[0][0]", val4, 72.0);
-
-
-		snprintf(Buffer, 17, "%.8E", val1 / HRS);
-		tempstr.assign(Buffer);
-		columns[0] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val2 / HRS);
-		tempstr.assign(Buffer);
-		columns[1] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val3 / HRS);
-		tempstr.assign(Buffer);
-		columns[2] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val4*RAD);
-		tempstr.assign(Buffer);
-		columns[3] = FixedWidthString(tempstr, 17U);
-
-		columns[4] = FormatID(ID, opp, cardnum);
-
-		card = columns[0] + columns[1] + columns[2] + columns[3] + columns[4];
-		out << card << std::endl;
-		cardnum++;
-
-		//Card 544
-		SearchForDouble(in, "LVDC_hx[0][1]", val1, 0.0);
-		SearchForDouble(in, "LVDC_hx[0][2]", val2, 0.0);
-		SearchForDouble(in, "LVDC_hx[0][3]", val3, 0.0);
-		SearchForDouble(in, "LVDC_hx[0][4]", val4, 0.0);
+		std::string Error;
 
-		snprintf(Buffer, 17, "%.8E", val1*RAD);
-		tempstr.assign(Buffer);
-		columns[0] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val2*RAD);
-		tempstr.assign(Buffer);
-		columns[1] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val3*RAD);
-		tempstr.assign(Buffer);
-		columns[2] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val4*RAD);
-		tempstr.assign(Buffer);
-		columns[3] = FixedWidthString(tempstr, 17U);
-
-		columns[4] = FormatID(ID, opp, cardnum);
-
-		card = columns[0] + columns[1] + columns[2] + columns[3] + columns[4];
-		out << card << std::endl;
-		cardnum++;
-
-		//Card 545
-		SearchForDouble(in, "LVDC_t_D1", val1, 0.0);
-		SearchForDouble(in, "LVDC_t_SD1", val2, 10984.2);
-		SearchForDouble(in, "LVDC_hx[1][0]", val3, 72.0);
-		SearchForDouble(in, "LVDC_hx[1][1]", val4, 0.0);
-
-		snprintf(Buffer, 17, "%.8E", val1 / HRS);
-		tempstr.assign(Buffer);
-		columns[0] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val2 / HRS);
-		tempstr.assign(Buffer);
-		columns[1] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val3*RAD);
-		tempstr.assign(Buffer);
-		columns[2] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val4*RAD);
-		tempstr.assign(Buffer);
-		columns[3] = FixedWidthString(tempstr, 17U);
-
-		columns[4] = FormatID(ID, opp, cardnum);
-
-		card = columns[0] + columns[1] + columns[2] + columns[3] + columns[4];
-		out << card << std::endl;
-		cardnum++;
-
-		//Card 546
-		SearchForDouble(in, "LVDC_hx[1][2]", val1, 0.0);
-		SearchForDouble(in, "LVDC_hx[1][3]", val2, 0.0);
-		SearchForDouble(in, "LVDC_hx[1][4]", val3, 0.0);
-		SearchForDouble(in, "LVDC_t_D2", val4, 10984.2);
-
-		snprintf(Buffer, 17, "%.8E", val1*RAD);
-		tempstr.assign(Buffer);
-		columns[0] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val2*RAD);
-		tempstr.assign(Buffer);
-		columns[1] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val3*RAD);
-		tempstr.assign(Buffer);
-		columns[2] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val4 / HRS);
-		tempstr.assign(Buffer);
-		columns[3] = FixedWidthString(tempstr, 17U);
-
-		columns[4] = FormatID(ID, opp, cardnum);
-
-		card = columns[0] + columns[1] + columns[2] + columns[3] + columns[4];
-		out << card << std::endl;
-		cardnum++;
-
-		//Card 547
-		SearchForDouble(in, "LVDC_t_SD2", val1, 5518.9);
-		SearchForDouble(in, "LVDC_hx[2][0]", val2, 72.0);
-		SearchForDouble(in, "LVDC_hx[2][1]", val3, 0.0);
-		SearchForDouble(in, "LVDC_hx[2][2]", val4, 0.0);
-
-		snprintf(Buffer, 17, "%.8E", val1 / HRS);
-		tempstr.assign(Buffer);
-		columns[0] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val2*RAD);
-		tempstr.assign(Buffer);
-		columns[1] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val3*RAD);
-		tempstr.assign(Buffer);
-		columns[2] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val4*RAD);
-		tempstr.assign(Buffer);
-		columns[3] = FixedWidthString(tempstr, 17U);
-
-		columns[4] = FormatID(ID, opp, cardnum);
-
-		card = columns[0] + columns[1] + columns[2] + columns[3] + columns[4];
-		out << card << std::endl;
-		cardnum++;
-
-		//Card 548
-		SearchForDouble(in, "LVDC_hx[2][3]", val1, 0.0);
-		SearchForDouble(in, "LVDC_hx[2][4]", val2, 0.0);
-		SearchForDouble(in, "LVDC_t_D3", val3, 16503.1);
-		SearchForDouble(in, "LVDC_t_SD3", val4, 1233.6);
-
-		snprintf(Buffer, 17, "%.8E", val1*RAD);
-		tempstr.assign(Buffer);
-		columns[0] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val2*RAD);
-		tempstr.assign(Buffer);
-		columns[1] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val3 / HRS);
-		tempstr.assign(Buffer);
-		columns[2] = FixedWidthString(tempstr, 17U);
-
-		snprintf(Buffer, 17, "%.8E", val4 / HRS);
-		tempstr.assign(Buffer);
-		columns[3] = FixedWidthString(tempstr, 17U);
-
-		columns[4] = FormatID(ID, opp, cardnum);
-
-		card = columns[0] + columns[1] + columns[2] + columns[3] + columns[4];
-		out << card << std::endl;
-		cardnum++;
-
-		in.close();
+		if (HaveYear == false || job.FileNameInArr.empty()) return false;
+		if (CheckLaunchDays(job.LaunchDayArr, Error) == false)
+		{
+			std::cout << "Deck " << job.FileNameOut << " " << Error << std::endl;
+			return false;
+		}
+		Jobs.push_back(job);
 	}
-}
+	else if (HaveYear || job.FileNameInArr.empty() == false) return false;
 
-bool SearchForDoubleOpp(std::ifstream &file, const char *str, char opp, int num, double &val, double defval)
-{
-	char Buff[128];
-	snprintf(Buff, 128, "%s%c%d", str, opp, num);
-	return SearchForDouble(file, Buff, val, defval);
-}
+	//The stats report would end up in the middle of a deck written to stdout
+	if (Options.StatsFile == StdStream && std::any_of(Jobs.begin(), Jobs.end(), [](const DeckJob &j) { return j.FileNameOut == StdStream; })) return false;
 
-bool SearchForDoubleOpp2(std::ifstream &file, const char *str, char opp, double &val, double defval)
-{
-	char Buff[128];
-	snprintf(Buff, 128, "%s%c", str, opp);
-	return SearchForDouble(file, Buff, val, defval);
+	return Jobs.empty() == false;
 }
 
-bool SearchForDouble(std::ifstream &file, const char *str, double &val, double defval)
+int PrintDiff(const RunOptions &Options)
 {
-	char buffer[256];
-	double e;
-	std::string line;
-	file.clear();
-	file.seekg(0);
+	std::vector<CardChange> Changes;
+	std::string Error;
+	int Changed = 0, Added = 0, Removed = 0;
 
-	while (std::getline(file, line))
+	if (DiffDecks(Options.DiffOld, Options.DiffNew, Changes, Error) == false)
 	{
-		if (sscanf_s(line.c_str(), "%s", buffer, 256) == 1) {
-			if (!strcmp(buffer, str)) {
-				if (sscanf_s(line.c_str(), "%s %lf", buffer, 256, &e) == 2) {
-					val = e;
-					return true;
-				}
-			}
-		}
+		std::cout << "File " << Error << "!" << std::endl;
+		return 2;
 	}
-	val = defval;
-	return false;
-}
 
-std::string FixedWidthString(std::string str, unsigned len)
-{
-	if (str.length() > len) return str;
-
-	std::string str2;
-	for (unsigned i = 0; i < len - str.length(); i++)
+	for (size_t i = 0; i < Changes.size(); i++)
 	{
-		str2.append(" ");
+		const CardChange &c = Changes[i];
+
+		if (c.Old.empty())
+		{
+			std::cout << "Card " << c.ID << " added" << std::endl;
+			Added++;
+		}
+		else if (c.New.empty())
+		{
+			std::cout << "Card " << c.ID << " removed" << std::endl;
+			Removed++;
+		}
+		else
+		{
+			for (int f = 0; f < 4; f++)
+			{
+				if ((c.Fields & (1 << f)) == 0) continue;
+				std::string Old = c.Old.substr(17 * f, 17), New = c.New.substr(17 * f, 17);
+				Old.erase(0, Old.find_first_not_of(' '));
+				New.erase(0, New.find_first_not_of(' '));
+				std::cout << "Card " << c.ID << " field " << f + 1 << ": " << Old << " -> " << New << std::endl;
+			}
+			Changed++;
+		}
 	}
-	str2.append(str);
-	return str2;
+	std::cout << Changed << " cards changed, " << Added << " added, " << Removed << " removed" << std::endl;
+	return Changes.empty() ? 0 : 1;
 }
-
-std::string FormatID(std::string ID, int Opp, int Card)
-{
-	char Buff[8];
-	std::string tempstr;
-
-	snprintf(Buff, 7, "%01d%03d", Opp, Card);
-	tempstr.assign(Buff);
-
-	return FixedWidthString(ID + tempstr, 12U);
-}
\ No newline at end of file